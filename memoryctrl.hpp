@@ -2,18 +2,50 @@
 #define MEMORYCTRL_H
 
 #include <new>
+#include <list>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <future>
 #include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <iterator>
 #include <type_traits>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define MEMORYCTRL_POSIX
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define MEMORYCTRL_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#if !defined(MEMORYCTRL_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MEMORYCTRL_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace memctrl {
 
 enum class ErrorType {
   no_error,
   out_of_range,
-  null_ponter
+  null_ponter,
+  system_error
 };
 
 class Error {
@@ -26,626 +58,4436 @@ public:
       case ErrorType::no_error: return "";
       case ErrorType::out_of_range: return "Out of range";
       case ErrorType::null_ponter: return "Null pointer";
+      case ErrorType::system_error: return "System call failed";
     }
   }
   operator ErrorType() const noexcept {return err_type;}
   operator bool() const noexcept {return err_type != ErrorType::no_error;}
 };
 
-class BufferController {
-  uint8_t* data = nullptr;
-  size_t size = 0;
-  size_t capacity = 0;
+// Default allocation policy of BufferController.
+// Any other policy must provide the same set of static functions,
+// alignment is a power of two and every returned block must satisfy it
+struct HeapAllocator {
+  static bool isOverAligned(size_t alignment) noexcept {return alignment > alignof (std::max_align_t);}
 
-  // Needed for calculate capacity
-  static size_t getNearestPow2(size_t num) noexcept {
-    num--;
-    num |= num >> 1;
-    num |= num >> 2;
-    num |= num >> 4;
-    num |= num >> 8;
-    num |= num >> 16;
-    num |= num >> 32;
-    num++;
-    return num;
-    // Another option to implement the function:
-    //  *reinterpret_cast<double*>(&num) = num;
-    //  return 1 << (((*(reinterpret_cast<uint32_t*>(&num) + 1) & 0x7FF00000) >> 20) - 1022);
+  static void* allocate(size_t size, size_t alignment) noexcept {
+    if(!isOverAligned(alignment)) return malloc(size);
+#ifdef _MSC_VER
+    return _aligned_malloc(size, alignment);
+#else
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+  }
+
+  static void* reallocate(void* data, size_t old_size, size_t new_size, size_t alignment) noexcept {
+    if(!isOverAligned(alignment)) return realloc(data, new_size);
+#ifdef _MSC_VER
+    (void)old_size;
+    return _aligned_realloc(data, new_size, alignment);
+#else
+    void* new_data = allocate(new_size, alignment);
+    if(!new_data) return nullptr;
+    memcpy(new_data, data, old_size < new_size ? old_size : new_size);
+    free(data);
+    return new_data;
+#endif
+  }
+
+  static void deallocate(void* data, size_t, size_t alignment) noexcept {
+#ifdef _MSC_VER
+    if(isOverAligned(alignment)) return _aligned_free(data);
+#else
+    (void)alignment;
+#endif
+    free(data);
+  }
+};
+
+// Allocation policy keeping freed power-of-two blocks in thread-local free lists,
+// one list per size class, and handing them out again on the next allocation
+template<typename Base = HeapAllocator, size_t DefaultLimit = 16, size_t MaxCachedSize = size_t(1) << 20>
+class RecyclingAllocator {
+  static constexpr size_t class_count = sizeof (size_t) * 8;
+
+  struct Limits {
+    std::atomic<size_t> counts[class_count];
+    Limits() noexcept {
+      for(size_t index = 0; index < class_count; ++index)
+        counts[index].store((size_t(1) << index) <= MaxCachedSize ? DefaultLimit : 0, std::memory_order_relaxed);
+    }
+  };
+
+  struct Cache {
+    void* heads[class_count] = {};
+    size_t counts[class_count] = {};
+    size_t alignments[class_count] = {};
+    size_t trim_epoch = 0;
+    ~Cache() {release(); isDestroyed() = true;}
+    void release(size_t index) noexcept {
+      while(void* block = heads[index]) {
+        heads[index] = *static_cast<void**>(block);
+        Base::deallocate(block, size_t(1) << index, alignments[index]);
+      }
+      counts[index] = 0;
+      alignments[index] = 0;
+    }
+    void release() noexcept {for(size_t index = 0; index < class_count; ++index) release(index);}
+  };
+
+  static Limits& getLimits() noexcept {static Limits limits; return limits;}
+  static std::atomic<size_t>& getTrimEpoch() noexcept {static std::atomic<size_t> epoch(0); return epoch;}
+  static bool& isDestroyed() noexcept {static thread_local bool destroyed = false; return destroyed;}
+
+  static Cache* getCache() noexcept {
+    if(isDestroyed()) return nullptr;
+    static thread_local Cache cache;
+    size_t epoch = getTrimEpoch().load(std::memory_order_relaxed);
+    if(cache.trim_epoch != epoch) {
+      cache.release();
+      cache.trim_epoch = epoch;
+    }
+    return &cache;
+  }
+
+  // Returns class_count for sizes that don't match any size class
+  static size_t getClassIndex(size_t size) noexcept {
+    if(size < sizeof (void*) || size > MaxCachedSize || (size & (size - 1))) return class_count;
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(size);
+#else
+    size_t index = 0;
+    while(size >>= 1) ++index;
+    return index;
+#endif
+  }
+
+  // Every list holds blocks allocated with the same alignment, so they are released the same way
+  static void* take(size_t index, size_t alignment) noexcept {
+    if(index == class_count) return nullptr;
+    Cache* cache = getCache();
+    if(!cache || !cache->heads[index] || cache->alignments[index] != alignment) return nullptr;
+    void* block = cache->heads[index];
+    cache->heads[index] = *static_cast<void**>(block);
+    --cache->counts[index];
+    return block;
+  }
+
+  static bool put(void* data, size_t index, size_t alignment) noexcept {
+    if(index == class_count) return false;
+    Cache* cache = getCache();
+    if(!cache || cache->counts[index] >= getLimits().counts[index].load(std::memory_order_relaxed)) return false;
+    if(cache->heads[index] && cache->alignments[index] != alignment) return false;
+    cache->alignments[index] = alignment;
+    *static_cast<void**>(data) = cache->heads[index];
+    cache->heads[index] = data;
+    ++cache->counts[index];
+    return true;
   }
 
 public:
+  static void* allocate(size_t size, size_t alignment) noexcept {
+    if(void* block = take(getClassIndex(size), alignment)) return block;
+    return Base::allocate(size, alignment);
+  }
 
-  typedef uint8_t byte;
-  typedef uint8_t* iterator;
-  typedef const uint8_t* const_iterator;
-  typedef std::reverse_iterator<iterator> reverse_iterator;
-  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+  static void* reallocate(void* data, size_t old_size, size_t new_size, size_t alignment) noexcept {
+    void* block = take(getClassIndex(new_size), alignment);
+    if(!block) return Base::reallocate(data, old_size, new_size, alignment);
+    memcpy(block, data, old_size < new_size ? old_size : new_size);
+    deallocate(data, old_size, alignment);
+    return block;
+  }
+
+  static void deallocate(void* data, size_t size, size_t alignment) noexcept {
+    if(!put(data, getClassIndex(size), alignment)) Base::deallocate(data, size, alignment);
+  }
 
-  BufferController() noexcept = default;
+  // Maximum count of cached blocks per thread for the size class of size
+  static void setLimit(size_t size, size_t count) noexcept {
+    size_t index = getClassIndex(size);
+    if(index != class_count) getLimits().counts[index].store(count, std::memory_order_relaxed);
+  }
 
-  BufferController(size_t size) noexcept
-    : data(new uint8_t[getNearestPow2(size)]),
-      size(size),
-      capacity(getNearestPow2(size)) {}
+  static size_t getLimit(size_t size) noexcept {
+    size_t index = getClassIndex(size);
+    return index != class_count ? getLimits().counts[index].load(std::memory_order_relaxed) : 0;
+  }
 
-  BufferController(void* buffer, size_t size) noexcept
-    : data(new uint8_t[getNearestPow2(size)]),
-      size(size),
-      capacity(getNearestPow2(size)) {memcpy(data, buffer, size);}
+  static size_t getCachedCount(size_t size) noexcept {
+    size_t index = getClassIndex(size);
+    if(index == class_count) return 0;
+    Cache* cache = getCache();
+    return cache ? cache->counts[index] : 0;
+  }
 
-  BufferController(BufferController& other) noexcept
-    : data(new uint8_t[other.size]),
-      size(other.size),
-      capacity(getNearestPow2(other.capacity)) {}
+  // Releases cached blocks of the calling thread
+  static void trim() noexcept {if(Cache* cache = getCache()) cache->release();}
 
-  BufferController(BufferController&& other) noexcept
-    : data(other.data),
-      size(other.size),
-      capacity(other.capacity) {other.data = nullptr;}
+  // Releases cached blocks of every thread, other threads do it on their next allocation
+  static void trimAll() noexcept {
+    getTrimEpoch().fetch_add(1, std::memory_order_relaxed);
+    trim();
+  }
+};
 
-  template<typename T>
-  BufferController(std::initializer_list<T> data_list)
-    : data(new uint8_t[getNearestPow2(data_list.size() * sizeof (T))]),
-      size(data_list.size() * sizeof (T)),
-      capacity(getNearestPow2(data_list.size() * sizeof (T))) {
-    T* it = begin<T>();
-    for(auto& element : data_list) {
-      *it = std::move(element);
-      it += sizeof (T);
+// Byte kernels with runtime selection of the widest instruction set the CPU supports
+namespace simd {
+
+#ifdef MEMORYCTRL_X86_SIMD
+enum class Level {
+  scalar,
+  sse2,
+  avx2,
+  avx512
+};
+
+inline Level getLevel() noexcept {
+  static const Level level = [] {
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) return Level::avx512;
+    if(__builtin_cpu_supports("avx2")) return Level::avx2;
+    if(__builtin_cpu_supports("sse2")) return Level::sse2;
+    return Level::scalar;
+  }();
+  return level;
+}
+#endif
+
+inline size_t firstMismatchScalar(const uint8_t* first, const uint8_t* second, size_t size) noexcept {
+  size_t index = 0;
+  for(; index + sizeof (uint64_t) <= size; index += sizeof (uint64_t)) {
+    uint64_t first_word, second_word;
+    memcpy(&first_word, first + index, sizeof (uint64_t));
+    memcpy(&second_word, second + index, sizeof (uint64_t));
+    if(first_word != second_word) break;
+  }
+  for(; index < size; ++index)
+    if(first[index] != second[index]) break;
+  return index;
+}
+
+#ifdef MEMORYCTRL_X86_SIMD
+__attribute__((target("sse2")))
+inline size_t firstMismatchSSE2(const uint8_t* first, const uint8_t* second, size_t size) noexcept {
+  size_t index = 0;
+  for(; index + 16 <= size; index += 16) {
+    __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + index)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + index)));
+    unsigned mask = _mm_movemask_epi8(equal) ^ 0xFFFF;
+    if(mask) return index + __builtin_ctz(mask);
+  }
+  return index + firstMismatchScalar(first + index, second + index, size - index);
+}
+
+__attribute__((target("avx2")))
+inline size_t firstMismatchAVX2(const uint8_t* first, const uint8_t* second, size_t size) noexcept {
+  size_t index = 0;
+  for(; index + 64 <= size; index += 64) {
+    __m256i low = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + index)),
+                                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + index)));
+    __m256i high = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + index + 32)),
+                                     _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + index + 32)));
+    if(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(low, high))) == 0xFFFFFFFF) continue;
+    unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(low));
+    if(mask) return index + __builtin_ctz(mask);
+    return index + 32 + __builtin_ctz(~static_cast<unsigned>(_mm256_movemask_epi8(high)));
+  }
+  for(; index + 32 <= size; index += 32) {
+    __m256i equal = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + index)),
+                                      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + index)));
+    unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(equal));
+    if(mask) return index + __builtin_ctz(mask);
+  }
+  return index + firstMismatchSSE2(first + index, second + index, size - index);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline size_t firstMismatchAVX512(const uint8_t* first, const uint8_t* second, size_t size) noexcept {
+  size_t index = 0;
+  for(; index + 64 <= size; index += 64) {
+    __mmask64 mask = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(first + index), _mm512_loadu_si512(second + index));
+    if(mask) return index + __builtin_ctzll(mask);
+  }
+  if(index == size) return size;
+  // Masked loads don't touch bytes past the end
+  __mmask64 tail = _cvtu64_mask64((uint64_t(1) << (size - index)) - 1);
+  __mmask64 mask = _mm512_mask_cmpneq_epi8_mask(tail, _mm512_maskz_loadu_epi8(tail, first + index),
+                                                _mm512_maskz_loadu_epi8(tail, second + index));
+  return mask ? index + __builtin_ctzll(mask) : size;
+}
+#endif
+
+// Index of the first different byte of two ranges, size if they are equal
+inline size_t firstMismatch(const void* first, const void* second, size_t size) noexcept {
+  const uint8_t* first_bytes = static_cast<const uint8_t*>(first);
+  const uint8_t* second_bytes = static_cast<const uint8_t*>(second);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512: return firstMismatchAVX512(first_bytes, second_bytes, size);
+    case Level::avx2: return firstMismatchAVX2(first_bytes, second_bytes, size);
+    case Level::sse2: return firstMismatchSSE2(first_bytes, second_bytes, size);
+    case Level::scalar: break;
+  }
+#endif
+  return firstMismatchScalar(first_bytes, second_bytes, size);
+}
+
+inline bool isEqual(const void* first, const void* second, size_t size) noexcept {
+  return firstMismatch(first, second, size) == size;
+}
+
+// Lexicographical comparison of unsigned bytes: negative, zero or positive like memcmp
+inline int compare(const void* first, size_t first_size, const void* second, size_t second_size) noexcept {
+  size_t size = first_size < second_size ? first_size : second_size;
+  size_t index = firstMismatch(first, second, size);
+  if(index < size)
+    return int(static_cast<const uint8_t*>(first)[index]) - int(static_cast<const uint8_t*>(second)[index]);
+  return first_size < second_size ? -1 : first_size > second_size;
+}
+
+inline size_t findByteScalar(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  const void* found = size ? memchr(data, value, size) : nullptr;
+  return found ? static_cast<const uint8_t*>(found) - data : size;
+}
+
+inline size_t countByteScalar(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  size_t count = 0;
+  for(size_t index = 0; index < size; ++index) count += data[index] == value;
+  return count;
+}
+
+inline size_t findAnyScalar(const uint8_t* data, size_t size, const uint8_t* set, size_t set_size) noexcept {
+  bool table[256] = {};
+  for(size_t index = 0; index < set_size; ++index) table[set[index]] = true;
+  for(size_t index = 0; index < size; ++index)
+    if(table[data[index]]) return index;
+  return size;
+}
+
+inline size_t findScalar(const uint8_t* data, size_t size, const uint8_t* needle, size_t needle_size) noexcept {
+  if(!needle_size) return 0;
+  for(size_t index = 0; index + needle_size <= size; ++index) {
+    index += findByteScalar(data + index, size - needle_size + 1 - index, needle[0]);
+    if(index + needle_size > size) break;
+    if(!memcmp(data + index, needle, needle_size)) return index;
+  }
+  return size;
+}
+
+#ifdef MEMORYCTRL_X86_SIMD
+__attribute__((target("sse2")))
+inline size_t findByteSSE2(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+  size_t index = 0;
+  for(; index + 16 <= size; index += 16) {
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index)), pattern));
+    if(mask) return index + __builtin_ctz(mask);
+  }
+  return index + findByteScalar(data + index, size - index, value);
+}
+
+__attribute__((target("avx2")))
+inline size_t findByteAVX2(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  __m256i pattern = _mm256_set1_epi8(static_cast<char>(value));
+  size_t index = 0;
+  for(; index + 32 <= size; index += 32) {
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index)), pattern));
+    if(mask) return index + __builtin_ctz(mask);
+  }
+  return index + findByteSSE2(data + index, size - index, value);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline size_t findByteAVX512(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  __m512i pattern = _mm512_set1_epi8(static_cast<char>(value));
+  size_t index = 0;
+  for(; index + 64 <= size; index += 64) {
+    __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + index), pattern);
+    if(mask) return index + __builtin_ctzll(mask);
+  }
+  if(index == size) return size;
+  __mmask64 tail = _cvtu64_mask64((uint64_t(1) << (size - index)) - 1);
+  __mmask64 mask = _mm512_mask_cmpeq_epi8_mask(tail, _mm512_maskz_loadu_epi8(tail, data + index), pattern);
+  return mask ? index + __builtin_ctzll(mask) : size;
+}
+
+__attribute__((target("sse2")))
+inline size_t countByteSSE2(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+  size_t count = 0;
+  size_t index = 0;
+  for(; index + 16 <= size; index += 16)
+    count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index)), pattern)));
+  return count + countByteScalar(data + index, size - index, value);
+}
+
+// Matches are accumulated in byte counters which are summed up every 255 blocks
+__attribute__((target("avx2")))
+inline size_t countByteAVX2(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  __m256i pattern = _mm256_set1_epi8(static_cast<char>(value));
+  size_t count = 0;
+  size_t index = 0;
+  while(index + 32 <= size) {
+    __m256i counters = _mm256_setzero_si256();
+    for(size_t block = 0; block < 255 && index + 32 <= size; ++block, index += 32)
+      counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index)), pattern));
+    // Each 64-bit sum is at most 8 * 255, so the low 32 bits hold it on 32-bit targets too
+    __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+    __m128i halves = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+    halves = _mm_add_epi64(halves, _mm_unpackhi_epi64(halves, halves));
+    count += uint32_t(_mm_cvtsi128_si32(halves));
+  }
+  return count + countByteSSE2(data + index, size - index, value);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+inline size_t countByteAVX512(const uint8_t* data, size_t size, uint8_t value) noexcept {
+  __m512i pattern = _mm512_set1_epi8(static_cast<char>(value));
+  size_t count = 0;
+  size_t index = 0;
+  for(; index + 64 <= size; index += 64)
+    count += __builtin_popcountll(_mm512_cmpeq_epi8_mask(_mm512_loadu_si512(data + index), pattern));
+  if(index == size) return count;
+  __mmask64 tail = _cvtu64_mask64((uint64_t(1) << (size - index)) - 1);
+  return count + __builtin_popcountll(_mm512_mask_cmpeq_epi8_mask(tail, _mm512_maskz_loadu_epi8(tail, data + index), pattern));
+}
+
+// Sets of up to 16 bytes are compared byte by byte, larger ones use a lookup table
+__attribute__((target("sse2")))
+inline size_t findAnySSE2(const uint8_t* data, size_t size, const uint8_t* set, size_t set_size) noexcept {
+  if(set_size > 16) return findAnyScalar(data, size, set, set_size);
+  size_t index = 0;
+  for(; index + 16 <= size; index += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+    __m128i matches = _mm_setzero_si128();
+    for(size_t set_index = 0; set_index < set_size; ++set_index)
+      matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(set[set_index]))));
+    unsigned mask = _mm_movemask_epi8(matches);
+    if(mask) return index + __builtin_ctz(mask);
+  }
+  return index + findAnyScalar(data + index, size - index, set, set_size);
+}
+
+__attribute__((target("avx2")))
+inline size_t findAnyAVX2(const uint8_t* data, size_t size, const uint8_t* set, size_t set_size) noexcept {
+  if(set_size > 16) return findAnyScalar(data, size, set, set_size);
+  size_t index = 0;
+  for(; index + 32 <= size; index += 32) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+    __m256i matches = _mm256_setzero_si256();
+    for(size_t set_index = 0; set_index < set_size; ++set_index)
+      matches = _mm256_or_si256(matches, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(set[set_index]))));
+    unsigned mask = _mm256_movemask_epi8(matches);
+    if(mask) return index + __builtin_ctz(mask);
+  }
+  return index + findAnySSE2(data + index, size - index, set, set_size);
+}
+
+// Blocks are filtered by the first and the last byte of the needle, candidates are verified with memcmp
+__attribute__((target("sse2")))
+inline size_t findSSE2(const uint8_t* data, size_t size, const uint8_t* needle, size_t needle_size) noexcept {
+  if(needle_size < 2 || needle_size > size) return needle_size ? findScalar(data, size, needle, needle_size) : 0;
+  __m128i first = _mm_set1_epi8(static_cast<char>(needle[0]));
+  __m128i last = _mm_set1_epi8(static_cast<char>(needle[needle_size - 1]));
+  size_t index = 0;
+  for(; index + needle_size - 1 + 16 <= size; index += 16) {
+    __m128i first_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+    __m128i last_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index + needle_size - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first), _mm_cmpeq_epi8(last_block, last)));
+    for(; mask; mask &= mask - 1) {
+      size_t candidate = index + __builtin_ctz(mask);
+      if(!memcmp(data + candidate + 1, needle + 1, needle_size - 2)) return candidate;
     }
   }
+  return index + findScalar(data + index, size - index, needle, needle_size);
+}
 
-  BufferController(std::initializer_list<BufferController> data_list) {
-    for(auto& element : data_list) capacity += element.size;
-    data = new uint8_t[capacity = getNearestPow2(capacity)];
-    for(auto& element : data_list) pushBack(std::move(element), static_cast<Error*>(nullptr));
+__attribute__((target("avx2")))
+inline size_t findAVX2(const uint8_t* data, size_t size, const uint8_t* needle, size_t needle_size) noexcept {
+  if(needle_size < 2 || needle_size > size) return needle_size ? findScalar(data, size, needle, needle_size) : 0;
+  __m256i first = _mm256_set1_epi8(static_cast<char>(needle[0]));
+  __m256i last = _mm256_set1_epi8(static_cast<char>(needle[needle_size - 1]));
+  size_t index = 0;
+  for(; index + needle_size - 1 + 32 <= size; index += 32) {
+    __m256i first_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+    __m256i last_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index + needle_size - 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first_block, first), _mm256_cmpeq_epi8(last_block, last)));
+    for(; mask; mask &= mask - 1) {
+      size_t candidate = index + __builtin_ctz(mask);
+      if(!memcmp(data + candidate + 1, needle + 1, needle_size - 2)) return candidate;
+    }
   }
+  return index + findSSE2(data + index, size - index, needle, needle_size);
+}
+#endif
 
-  ~BufferController() {clear();}
+// Search functions return the index of the first match or size if nothing is found
 
-  static BufferController move(const void* buffer, size_t size) noexcept {
-    BufferController ctrl;
-    ctrl.data = (uint8_t*)buffer;
-    ctrl.size = size;
-    ctrl.capacity = size;
-    return ctrl;
+inline size_t findByte(const void* data, size_t size, uint8_t value) noexcept {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512: return findByteAVX512(bytes, size, value);
+    case Level::avx2: return findByteAVX2(bytes, size, value);
+    case Level::sse2: return findByteSSE2(bytes, size, value);
+    case Level::scalar: break;
   }
+#endif
+  return findByteScalar(bytes, size, value);
+}
 
-  bool isEmpty() const noexcept {return !size;}
-  bool isCapacityEmpty() const noexcept {return !data || !capacity;}
-  void* getData() const noexcept {return data;}
+inline size_t countByte(const void* data, size_t size, uint8_t value) noexcept {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512: return countByteAVX512(bytes, size, value);
+    case Level::avx2: return countByteAVX2(bytes, size, value);
+    case Level::sse2: return countByteSSE2(bytes, size, value);
+    case Level::scalar: break;
+  }
+#endif
+  return countByteScalar(bytes, size, value);
+}
 
-  size_t getSize() const noexcept {return size;}
-  size_t getCapacity() const noexcept {return capacity;}
-  template<typename T>
-  size_t getCount() const noexcept {return size/sizeof(T);}
-  template<typename T>
-  size_t getCapacity() const noexcept {return capacity/sizeof (T);}
+inline size_t findAny(const void* data, size_t size, const void* set, size_t set_size) noexcept {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  const uint8_t* set_bytes = static_cast<const uint8_t*>(set);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512:
+    case Level::avx2: return findAnyAVX2(bytes, size, set_bytes, set_size);
+    case Level::sse2: return findAnySSE2(bytes, size, set_bytes, set_size);
+    case Level::scalar: break;
+  }
+#endif
+  return findAnyScalar(bytes, size, set_bytes, set_size);
+}
 
-  void clear() noexcept {if(data) delete[] data; size = 0; capacity = 0;}
+inline size_t find(const void* data, size_t size, const void* needle, size_t needle_size) noexcept {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  const uint8_t* needle_bytes = static_cast<const uint8_t*>(needle);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512:
+    case Level::avx2: return findAVX2(bytes, size, needle_bytes, needle_size);
+    case Level::sse2: return findSSE2(bytes, size, needle_bytes, needle_size);
+    case Level::scalar: break;
+  }
+#endif
+  return findScalar(bytes, size, needle_bytes, needle_size);
+}
 
-  void resize(size_t new_size) noexcept {
-    if(size == new_size) return;
-    else if(size >= new_size || capacity >= new_size) {
-      size = new_size;
-      return;
-    } else {
-      capacity = getNearestPow2(new_size);
-      data = (uint8_t*)realloc(data, capacity);
-      size = new_size;
-      return;
+#ifdef MEMORYCTRL_X86_SIMD
+inline bool hasCRC32() noexcept {
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return bool(__builtin_cpu_supports("sse4.2"));
+  }();
+  return supported;
+}
+#endif
+
+// Slicing-by-8 tables of the reflected Castagnoli polynomial
+struct CRC32CTable {
+  uint32_t entries[8][256];
+
+  constexpr CRC32CTable() noexcept : entries() {
+    for(uint32_t index = 0; index < 256; ++index) {
+      uint32_t crc = index;
+      for(int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+      entries[0][index] = crc;
     }
+    for(uint32_t index = 0; index < 256; ++index)
+      for(int slice = 1; slice < 8; ++slice)
+        entries[slice][index] = (entries[slice - 1][index] >> 8) ^ entries[0][entries[slice - 1][index] & 0xFF];
   }
+};
 
-  template<typename T>
-  void resize(size_t count) noexcept {return resize(count * sizeof(T));}
+inline uint32_t crc32cScalar(uint32_t crc, const uint8_t* data, size_t size) noexcept {
+  static constexpr CRC32CTable table;
+  const auto& entries = table.entries;
+  for(; size >= 8; data += 8, size -= 8) {
+    uint32_t low = crc ^ (uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24);
+    crc = entries[7][low & 0xFF] ^ entries[6][(low >> 8) & 0xFF] ^
+          entries[5][(low >> 16) & 0xFF] ^ entries[4][low >> 24] ^
+          entries[3][data[4]] ^ entries[2][data[5]] ^ entries[1][data[6]] ^ entries[0][data[7]];
+  }
+  for(; size; ++data, --size) crc = (crc >> 8) ^ entries[0][(crc ^ *data) & 0xFF];
+  return crc;
+}
 
-  void reserve(size_t new_capacity) noexcept {
-    if(capacity >= new_capacity) return;
-    capacity = getNearestPow2(new_capacity);
-    data = (uint8_t*)realloc(data, capacity);
-    if(capacity < size) size = capacity;
+#ifdef MEMORYCTRL_X86_SIMD
+__attribute__((target("sse4.2")))
+inline uint32_t crc32cSSE42(uint32_t crc, const uint8_t* data, size_t size) noexcept {
+#ifdef __x86_64__
+  uint64_t crc64 = crc;
+  for(; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof (uint64_t));
+    crc64 = _mm_crc32_u64(crc64, word);
   }
+  crc = uint32_t(crc64);
+#endif
+  for(; size >= 4; data += 4, size -= 4) {
+    uint32_t word;
+    memcpy(&word, data, sizeof (uint32_t));
+    crc = _mm_crc32_u32(crc, word);
+  }
+  for(; size; ++data, --size) crc = _mm_crc32_u8(crc, *data);
+  return crc;
+}
+#endif
 
-  template<typename T>
-  void reserve(size_t count) noexcept {return reserve(count * sizeof (T));}
+// CRC-32C of data, pass the previous result as crc to continue a checksum over several ranges
+inline uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0) noexcept {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+#ifdef MEMORYCTRL_X86_SIMD
+  if(hasCRC32()) return ~crc32cSSE42(~crc, bytes, size);
+#endif
+  return ~crc32cScalar(~crc, bytes, size);
+}
 
-  void shrinkToFit() noexcept {
-    if(size == capacity) return;
-    capacity = size;
-    data = (uint8_t*)realloc(data, capacity);
+#ifdef MEMORYCTRL_X86_SIMD
+// Non-temporal copies write around the cache, the destination is aligned by
+// copying its head with memcpy, the stores are fenced before return
+
+__attribute__((target("sse2")))
+inline void streamCopySSE2(uint8_t* destination, const uint8_t* source, size_t size) noexcept {
+  size_t head = (16 - (uintptr_t(destination) & 15)) & 15;
+  if(head > size) head = size;
+  memcpy(destination, source, head);
+  size_t index = head;
+  for(; index + 64 <= size; index += 64)
+    for(size_t lane = 0; lane < 64; lane += 16)
+      _mm_stream_si128(reinterpret_cast<__m128i*>(destination + index + lane),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index + lane)));
+  _mm_sfence();
+  memcpy(destination + index, source + index, size - index);
+}
+
+__attribute__((target("avx2")))
+inline void streamCopyAVX2(uint8_t* destination, const uint8_t* source, size_t size) noexcept {
+  size_t head = (32 - (uintptr_t(destination) & 31)) & 31;
+  if(head > size) head = size;
+  memcpy(destination, source, head);
+  size_t index = head;
+  for(; index + 128 <= size; index += 128)
+    for(size_t lane = 0; lane < 128; lane += 32)
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + index + lane),
+                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + index + lane)));
+  _mm_sfence();
+  memcpy(destination + index, source + index, size - index);
+}
+
+__attribute__((target("avx512f")))
+inline void streamCopyAVX512(uint8_t* destination, const uint8_t* source, size_t size) noexcept {
+  size_t head = (64 - (uintptr_t(destination) & 63)) & 63;
+  if(head > size) head = size;
+  memcpy(destination, source, head);
+  size_t index = head;
+  for(; index + 256 <= size; index += 256)
+    for(size_t lane = 0; lane < 256; lane += 64)
+      _mm512_stream_si512(reinterpret_cast<__m512i*>(destination + index + lane), _mm512_loadu_si512(source + index + lane));
+  _mm_sfence();
+  memcpy(destination + index, source + index, size - index);
+}
+#endif
+
+// Copies non-overlapping ranges bypassing the cache where the CPU allows it
+inline void streamCopy(void* destination, const void* source, size_t size) noexcept {
+  uint8_t* destination_bytes = static_cast<uint8_t*>(destination);
+  const uint8_t* source_bytes = static_cast<const uint8_t*>(source);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512: return streamCopyAVX512(destination_bytes, source_bytes, size);
+    case Level::avx2: return streamCopyAVX2(destination_bytes, source_bytes, size);
+    case Level::sse2: return streamCopySSE2(destination_bytes, source_bytes, size);
+    case Level::scalar: break;
   }
+#endif
+  memcpy(destination_bytes, source_bytes, size);
+}
 
-  void subSizeBack(size_t sub) noexcept {return resize(size - sub);}
+#ifdef MEMORYCTRL_X86_SIMD
+__attribute__((target("sse2")))
+inline void streamFillSSE2(uint8_t* destination, size_t size, uint8_t value) noexcept {
+  size_t head = (16 - (uintptr_t(destination) & 15)) & 15;
+  if(head > size) head = size;
+  memset(destination, value, head);
+  __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+  size_t index = head;
+  for(; index + 16 <= size; index += 16) _mm_stream_si128(reinterpret_cast<__m128i*>(destination + index), pattern);
+  _mm_sfence();
+  memset(destination + index, value, size - index);
+}
 
-  void subSizeFront(size_t sub) noexcept {
-    memmove(data, data + sub, size - sub);
-    return resize(size - sub);
+__attribute__((target("avx2")))
+inline void streamFillAVX2(uint8_t* destination, size_t size, uint8_t value) noexcept {
+  size_t head = (32 - (uintptr_t(destination) & 31)) & 31;
+  if(head > size) head = size;
+  memset(destination, value, head);
+  __m256i pattern = _mm256_set1_epi8(static_cast<char>(value));
+  size_t index = head;
+  for(; index + 32 <= size; index += 32) _mm256_stream_si256(reinterpret_cast<__m256i*>(destination + index), pattern);
+  _mm_sfence();
+  memset(destination + index, value, size - index);
+}
+
+__attribute__((target("avx512f")))
+inline void streamFillAVX512(uint8_t* destination, size_t size, uint8_t value) noexcept {
+  size_t head = (64 - (uintptr_t(destination) & 63)) & 63;
+  if(head > size) head = size;
+  memset(destination, value, head);
+  __m512i pattern = _mm512_set1_epi8(static_cast<char>(value));
+  size_t index = head;
+  for(; index + 64 <= size; index += 64) _mm512_stream_si512(reinterpret_cast<__m512i*>(destination + index), pattern);
+  _mm_sfence();
+  memset(destination + index, value, size - index);
+}
+#endif
+
+// Fills bypassing the cache where the CPU allows it
+inline void streamFill(void* destination, size_t size, uint8_t value) noexcept {
+  uint8_t* bytes = static_cast<uint8_t*>(destination);
+#ifdef MEMORYCTRL_X86_SIMD
+  switch (getLevel()) {
+    case Level::avx512: return streamFillAVX512(bytes, size, value);
+    case Level::avx2: return streamFillAVX2(bytes, size, value);
+    case Level::sse2: return streamFillSSE2(bytes, size, value);
+    case Level::scalar: break;
   }
+#endif
+  memset(bytes, value, size);
+}
 
-  void subSizeFrom(size_t at, size_t sub) noexcept {
-    memmove(data + at, data + at + sub, size - sub - at);
-    return resize(size - sub);
+}
+
+// Streaming XXH64, the four accumulator lanes are independent and run in parallel in the pipeline
+class XXHash64 {
+  static constexpr uint64_t prime1 = 0x9E3779B185EBCA87;
+  static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+  static constexpr uint64_t prime3 = 0x165667B19E3779F9;
+  static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63;
+  static constexpr uint64_t prime5 = 0x27D4EB2F165667C5;
+
+  uint64_t lanes[4];
+  uint64_t seed;
+  uint64_t total_size;
+  uint8_t tail[32];
+  size_t tail_size;
+
+  static uint64_t rotl(uint64_t value, int shift) noexcept {return (value << shift) | (value >> (64 - shift));}
+
+  static uint64_t load64(const uint8_t* data) noexcept {
+    uint64_t value = 0;
+    for(int index = 7; index >= 0; --index) value = value << 8 | data[index];
+    return value;
   }
 
-  iterator addSizeToBack(size_t add) noexcept {
-    size_t old_size = size;
-    resize(size + add);
-    return data + old_size;
+  static uint64_t load32(const uint8_t* data) noexcept {
+    return uint64_t(data[0]) | uint64_t(data[1]) << 8 | uint64_t(data[2]) << 16 | uint64_t(data[3]) << 24;
   }
 
-  iterator addSizeToFront(size_t add) noexcept {
-    size_t old_size = size;
-    addSizeToBack(add);
-    memmove(data + add, data, old_size);
-    return data;
+  static uint64_t round(uint64_t lane, uint64_t input) noexcept {return rotl(lane + input * prime2, 31) * prime1;}
+
+  static uint64_t mergeRound(uint64_t hash, uint64_t lane) noexcept {return (hash ^ round(0, lane)) * prime1 + prime4;}
+
+  void consume(const uint8_t* data) noexcept {
+    for(int lane = 0; lane < 4; ++lane) lanes[lane] = round(lanes[lane], load64(data + lane * 8));
   }
 
-  iterator addSizeTo(size_t to, size_t add) noexcept {
-    size_t old_size = size;
-    addSizeToBack(add);
-    iterator it = data + to;
-    memmove(it + add, it, old_size - add);
-    return it;
+public:
+  XXHash64(uint64_t seed = 0) noexcept {reset(seed);}
+
+  void reset(uint64_t seed = 0) noexcept {
+    lanes[0] = seed + prime1 + prime2;
+    lanes[1] = seed + prime2;
+    lanes[2] = seed;
+    lanes[3] = seed - prime1;
+    this->seed = seed;
+    total_size = 0;
+    tail_size = 0;
   }
 
-  iterator pushBack(const void* data, size_t size, Error* err = nullptr) noexcept {
-    if(!data) {
-      if(err) *err = ErrorType::null_ponter;
-      return end();
+  XXHash64& update(const void* data, size_t size) noexcept {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    total_size += size;
+    if(tail_size) {
+      size_t fill = 32 - tail_size < size ? 32 - tail_size : size;
+      memcpy(tail + tail_size, bytes, fill);
+      tail_size += fill;
+      bytes += fill;
+      size -= fill;
+      if(tail_size < 32) return *this;
+      consume(tail);
+      tail_size = 0;
     }
-    auto data_it = addSizeToBack(size);
-    memmove(data_it, data, size);
-    return data_it;
+    for(; size >= 32; bytes += 32, size -= 32) consume(bytes);
+    if(size) memcpy(tail, bytes, tail_size = size);
+    return *this;
   }
 
-  iterator insert(size_t to, const void* data, size_t size, Error* err = nullptr) noexcept {
-    if(!data) {
-      if(err) *err = ErrorType::null_ponter;
-      return end();
-    }
-    if(to > size) {
-      if(err) *err = ErrorType::out_of_range;
-      return end();
+  template<typename Buffer>
+  XXHash64& update(const Buffer& buffer) noexcept {return update(buffer.getData(), buffer.getSize());}
+
+  uint64_t digest() const noexcept {
+    uint64_t hash;
+    if(total_size >= 32) {
+      hash = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+      for(int lane = 0; lane < 4; ++lane) hash = mergeRound(hash, lanes[lane]);
+    } else hash = seed + prime5;
+    hash += total_size;
+
+    const uint8_t* data = tail;
+    size_t size = tail_size;
+    for(; size >= 8; data += 8, size -= 8) hash = rotl(hash ^ round(0, load64(data)), 27) * prime1 + prime4;
+    if(size >= 4) {
+      hash = rotl(hash ^ (load32(data) * prime1), 23) * prime2 + prime3;
+      data += 4;
+      size -= 4;
     }
-    auto data_it = addSizeTo(to, size);
-    memmove(data_it, data, size);
-    return data_it;
+    for(; size; ++data, --size) hash = rotl(hash ^ (*data * prime5), 11) * prime1;
+
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    hash *= prime3;
+    hash ^= hash >> 32;
+    return hash;
   }
+};
 
-  iterator pushFront(const void* data, size_t size, Error* err = nullptr) noexcept {
-    if(!data) {
-      if(err) *err = ErrorType::null_ponter;
-      return end();
+inline uint64_t xxhash64(const void* data, size_t size, uint64_t seed = 0) noexcept {
+  return XXHash64(seed).update(data, size).digest();
+}
+
+// Splits large copies and buffer shifts between worker threads, disabled until setThreadCount
+// is called. Copies bigger than the streaming threshold, the last level cache size by default,
+// use non-temporal stores with or without threads, so they don't evict the working set of others
+class ParallelCopy {
+  struct Task {
+    uint8_t* destination;
+    const uint8_t* source;
+    size_t size;
+    bool stream;
+    std::atomic<size_t>* remaining;
+  };
+
+  struct Pool {
+    std::mutex mutex;
+    std::condition_variable task_condition;
+    std::deque<Task> tasks;
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    ~Pool() {stop();}
+
+    void work() noexcept {
+      std::unique_lock<std::mutex> lock(mutex);
+      while(true) {
+        task_condition.wait(lock, [this] {return stopping || !tasks.empty();});
+        if(tasks.empty()) return;
+        Task task = tasks.front();
+        tasks.pop_front();
+        lock.unlock();
+        run(task);
+        lock.lock();
+      }
     }
-    auto data_it = addSizeToFront(size);
-    memmove(data_it, data, size);
-    return data_it;
+
+    // Lets a waiting caller help with queued tasks
+    bool runQueued() noexcept {
+      std::unique_lock<std::mutex> lock(mutex);
+      if(tasks.empty()) return false;
+      Task task = tasks.front();
+      tasks.pop_front();
+      lock.unlock();
+      run(task);
+      return true;
+    }
+
+    void stop() noexcept {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      task_condition.notify_all();
+      for(auto& thread : threads) thread.join();
+      threads.clear();
+      stopping = false;
+    }
+  };
+
+  static Pool& getPool() noexcept {
+    static Pool pool;
+    return pool;
   }
 
-  iterator pushBack(const BufferController& other, Error* err = nullptr) noexcept {
-    return pushBack(other.data, other.size, err);
+  static std::atomic<size_t>& getThreadCountValue() noexcept {
+    static std::atomic<size_t> thread_count(0);
+    return thread_count;
   }
 
-  iterator pushBack(BufferController&& other, Error* err = nullptr) noexcept {
-    return pushBack(other.data, other.size, err);
+  static std::atomic<size_t>& getThresholdValue() noexcept {
+    static std::atomic<size_t> threshold(size_t(4) << 20);
+    return threshold;
+  }
+
+  static std::atomic<size_t>& getStreamingThresholdValue() noexcept {
+    static std::atomic<size_t> threshold(getLastLevelCacheSize());
+    return threshold;
+  }
+
+  static void run(const Task& task) noexcept {
+    if(task.stream) simd::streamCopy(task.destination, task.source, task.size);
+    else memcpy(task.destination, task.source, task.size);
+    task.remaining->fetch_sub(1, std::memory_order_release);
+  }
+
+  static void copyParallel(uint8_t* destination, const uint8_t* source, size_t size, size_t thread_count) noexcept {
+    // Chunks of whole pages, at least 1 MiB each
+    size_t chunk_count = thread_count + 1;
+    if(chunk_count > size >> 20) chunk_count = size >> 20 ? size >> 20 : 1;
+    size_t chunk_size = (size / chunk_count + 4095) & ~size_t(4095);
+    bool stream = size >= getStreamingThreshold();
+    std::atomic<size_t> remaining(0);
+    Pool& pool = getPool();
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      for(size_t offset = chunk_size; offset < size; offset += chunk_size) {
+        remaining.fetch_add(1, std::memory_order_relaxed);
+        pool.tasks.push_back(Task{destination + offset, source + offset,
+                                  size - offset < chunk_size ? size - offset : chunk_size, stream, &remaining});
+      }
+    }
+    pool.task_condition.notify_all();
+    remaining.fetch_add(1, std::memory_order_relaxed);
+    run(Task{destination, source, size < chunk_size ? size : chunk_size, stream, &remaining});
+    while(remaining.load(std::memory_order_acquire))
+      if(!pool.runQueued()) std::this_thread::yield();
   }
 
-  iterator insert(size_t to, const BufferController& other, Error* err = nullptr) noexcept {
-    return insert(to, other.data, other.size, err);
-  }
+public:
+
+  static size_t getLastLevelCacheSize() noexcept {
+#if defined(MEMORYCTRL_POSIX) && defined(_SC_LEVEL3_CACHE_SIZE)
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if(size > 0) return size;
+#endif
+    return size_t(32) << 20;
+  }
+
+  // Count of worker threads besides the caller, 0 disables the parallel path.
+  // Must not be called while copies are running
+  static void setThreadCount(size_t count) {
+    Pool& pool = getPool();
+    pool.stop();
+    for(size_t index = 0; index < count; ++index) pool.threads.emplace_back(&Pool::work, &pool);
+    getThreadCountValue().store(count, std::memory_order_relaxed);
+  }
+
+  static size_t getThreadCount() noexcept {return getThreadCountValue().load(std::memory_order_relaxed);}
+
+  // Minimum size of a copy split between threads
+  static void setThreshold(size_t size) noexcept {getThresholdValue().store(size, std::memory_order_relaxed);}
+  static size_t getThreshold() noexcept {return getThresholdValue().load(std::memory_order_relaxed);}
+
+  // Minimum size of a copy using non-temporal stores
+  static void setStreamingThreshold(size_t size) noexcept {
+    getStreamingThresholdValue().store(size, std::memory_order_relaxed);
+  }
+  static size_t getStreamingThreshold() noexcept {return getStreamingThresholdValue().load(std::memory_order_relaxed);}
+
+  // Ranges must not overlap
+  static void copy(void* destination, const void* source, size_t size) noexcept {
+    size_t thread_count = getThreadCount();
+    if(!thread_count || size < getThreshold()) {
+      if(size >= getStreamingThreshold()) return simd::streamCopy(destination, source, size);
+      return void(memcpy(destination, source, size));
+    }
+    copyParallel(static_cast<uint8_t*>(destination), static_cast<const uint8_t*>(source), size, thread_count);
+  }
+
+  // Overlapping ranges are copied in rounds of the shift distance, walking away from the
+  // destination side, so no round overlaps and each one can be split between threads
+  static void move(void* destination, const void* source, size_t size) noexcept {
+    uint8_t* destination_bytes = static_cast<uint8_t*>(destination);
+    const uint8_t* source_bytes = static_cast<const uint8_t*>(source);
+    if(destination_bytes == source_bytes || !size) return;
+    size_t distance = destination_bytes < source_bytes ? source_bytes - destination_bytes
+                                                       : destination_bytes - source_bytes;
+    if(distance >= size) return copy(destination, source, size);
+    size_t thread_count = getThreadCount();
+    if(!thread_count || distance < getThreshold()) return void(memmove(destination, source, size));
+    if(destination_bytes < source_bytes) {
+      for(size_t offset = 0; offset < size; offset += distance) {
+        size_t block = size - offset < distance ? size - offset : distance;
+        copyParallel(destination_bytes + offset, source_bytes + offset, block, thread_count);
+      }
+    } else {
+      for(size_t end = size; end;) {
+        size_t block = end < distance ? end : distance;
+        end -= block;
+        copyParallel(destination_bytes + end, source_bytes + end, block, thread_count);
+      }
+    }
+  }
+};
+
+// Non-owning typed range of elements, valid while the owner of the memory
+// doesn't reallocate or move it
+template<typename T>
+class TypedView {
+  T* data = nullptr;
+  size_t count = 0;
+public:
+
+  typedef T Type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  TypedView() noexcept = default;
+  TypedView(T* data, size_t count) noexcept : data(data), count(count) {}
+
+  bool isEmpty() const noexcept {return !count;}
+  T* getData() const noexcept {return data;}
+  size_t getCount() const noexcept {return count;}
+
+  T& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= count) {
+      if(err) *err = ErrorType::out_of_range;
+      return data[count - 1];
+    }
+    return data[at];
+  }
+
+  TypedView slice(size_t at, size_t count, Error* err = nullptr) const noexcept {
+    if(at + count > this->count) {
+      if(err) *err = ErrorType::out_of_range;
+      return TypedView();
+    }
+    return TypedView(data + at, count);
+  }
+
+  TypedView takeFront(size_t count, Error* err = nullptr) noexcept {
+    if(count > this->count) {
+      if(err) *err = ErrorType::out_of_range;
+      return TypedView();
+    }
+    TypedView front(data, count);
+    data += count;
+    this->count -= count;
+    return front;
+  }
+
+  TypedView takeBack(size_t count, Error* err = nullptr) noexcept {
+    if(count > this->count) {
+      if(err) *err = ErrorType::out_of_range;
+      return TypedView();
+    }
+    this->count -= count;
+    return TypedView(data + this->count, count);
+  }
+
+  iterator begin() const noexcept {return data;}
+  iterator end() const noexcept {return data + count;}
+
+  T& operator[](size_t index) const noexcept {return data[index];}
+};
+
+// Non-owning range of bytes, valid while the owner of the memory
+// doesn't reallocate or move it
+class BufferView {
+  uint8_t* data = nullptr;
+  size_t size = 0;
+public:
+
+  typedef uint8_t byte;
+  typedef uint8_t* iterator;
+  typedef const uint8_t* const_iterator;
+
+  BufferView() noexcept = default;
+  BufferView(const void* data, size_t size) noexcept
+    : data(static_cast<uint8_t*>(const_cast<void*>(data))), size(size) {}
+
+  bool isEmpty() const noexcept {return !size;}
+  void* getData() const noexcept {return data;}
+  size_t getSize() const noexcept {return size;}
+  template<typename T>
+  size_t getCount() const noexcept {return size/sizeof (T);}
+
+  byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= size) {
+      if(err) *err = ErrorType::out_of_range;
+      return data[size - 1];
+    }
+    return data[at];
+  }
+
+  template<typename T>
+  T& get(size_t at, size_t shift, Error* err = nullptr) const noexcept {
+    return *reinterpret_cast<T*>(&get(at * sizeof (T) + shift, err));
+  }
+
+  BufferView slice(size_t at, size_t size, Error* err = nullptr) const noexcept {
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    return BufferView(data + at, size);
+  }
+
+  void subSizeFront(size_t sub) noexcept {
+    if(sub > size) sub = size;
+    data += sub;
+    size -= sub;
+  }
+
+  void subSizeBack(size_t sub) noexcept {size -= sub > size ? size : sub;}
+
+  // Slices bytes off the view without copying them
+  BufferView takeFront(size_t size, Error* err = nullptr) noexcept {
+    if(size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    BufferView front(data, size);
+    subSizeFront(size);
+    return front;
+  }
+
+  BufferView takeBack(size_t size, Error* err = nullptr) noexcept {
+    if(size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    subSizeBack(size);
+    return BufferView(data + this->size, size);
+  }
+
+  template<typename T>
+  TypedView<T> as() const noexcept {return TypedView<T>(reinterpret_cast<T*>(data), getCount<T>());}
+
+#ifdef MEMORYCTRL_POSIX
+  iovec getIovec() const noexcept {return iovec{data, size};}
+
+  // Writes until the view is empty or fd would block, written bytes are sliced off the front
+  size_t writeTo(int fd, Error* err = nullptr) noexcept {
+    size_t total = 0;
+    while(size) {
+      ssize_t result = write(fd, data, size);
+      if(result < 0) {
+        if(errno == EINTR) continue;
+        if(errno != EAGAIN && errno != EWOULDBLOCK && err) *err = ErrorType::system_error;
+        break;
+      }
+      if(!result) break;
+      subSizeFront(result);
+      total += result;
+    }
+    return total;
+  }
+#endif
+
+  iterator begin() const noexcept {return data;}
+  iterator end() const noexcept {return data + size;}
+
+  template<typename T>
+  T* begin() const noexcept {return reinterpret_cast<T*>(data);}
+  template<typename T>
+  T* end() const noexcept {return reinterpret_cast<T*>(data) + getCount<T>();}
+
+  byte& operator[](size_t index) const noexcept {return data[index];}
+
+  size_t firstMismatch(const BufferView& other) const noexcept {
+    return simd::firstMismatch(data, other.data, size < other.size ? size : other.size);
+  }
+
+  int compare(const BufferView& other) const noexcept {return simd::compare(data, size, other.data, other.size);}
+
+  bool operator==(const BufferView& other) const noexcept {
+    return size == other.size && simd::isEqual(data, other.data, size);
+  }
+
+  bool operator!=(const BufferView& other) const noexcept {return !(*this == other);}
+  bool operator<(const BufferView& other) const noexcept {return compare(other) < 0;}
+
+  // Search functions return the index of the first match or size if nothing is found
+
+  size_t find(byte value, size_t from = 0) const noexcept {
+    if(from >= size) return size;
+    return from + simd::findByte(data + from, size - from, value);
+  }
+
+  size_t find(const void* needle, size_t needle_size, size_t from = 0) const noexcept {
+    if(from > size) return size;
+    size_t index = simd::find(data + from, size - from, needle, needle_size);
+    return index == size - from ? size : from + index;
+  }
+
+  size_t find(const BufferView& needle, size_t from = 0) const noexcept {return find(needle.data, needle.size, from);}
+
+  size_t findAny(const void* set, size_t set_size, size_t from = 0) const noexcept {
+    if(from >= size) return size;
+    return from + simd::findAny(data + from, size - from, set, set_size);
+  }
+
+  size_t findAny(const BufferView& set, size_t from = 0) const noexcept {return findAny(set.data, set.size, from);}
+
+  size_t count(byte value) const noexcept {return simd::countByte(data, size, value);}
+
+  // Pass the previous result to continue a checksum over several views
+  uint32_t crc32c(uint32_t crc = 0) const noexcept {return simd::crc32c(data, size, crc);}
+  uint64_t xxhash64(uint64_t seed = 0) const noexcept {return memctrl::xxhash64(data, size, seed);}
+
+  // Splits into views over this memory, n delimiters always give n + 1 pieces
+  std::vector<BufferView> split(byte delimiter) const {
+    std::vector<BufferView> pieces;
+    pieces.reserve(count(delimiter) + 1);
+    size_t from = 0;
+    for(size_t index; (index = find(delimiter, from)) != size; from = index + 1)
+      pieces.emplace_back(data + from, index - from);
+    pieces.emplace_back(data + from, size - from);
+    return pieces;
+  }
+
+  std::vector<BufferView> split(const BufferView& delimiter) const {
+    std::vector<BufferView> pieces;
+    size_t from = 0;
+    if(delimiter.size)
+      for(size_t index; (index = find(delimiter, from)) != size; from = index + delimiter.size)
+        pieces.emplace_back(data + from, index - from);
+    pieces.emplace_back(data + from, size - from);
+    return pieces;
+  }
+};
+
+// Memory usage hints for BufferController::advise
+enum class Advice {
+  normal,
+  sequential,
+  random,
+  will_need,
+  populate,
+  huge_pages,
+  no_huge_pages
+};
+
+// Allocators may also provide static release(data, capacity, old_size, new_size),
+// it is called when the size of a buffer decreases without reallocation
+template<typename Allocator, typename = void>
+struct HasRelease : std::false_type {};
+
+template<typename Allocator>
+struct HasRelease<Allocator, std::void_t<decltype(Allocator::release(nullptr, size_t(), size_t(), size_t()))>>
+  : std::true_type {};
+
+#ifdef MEMORYCTRL_POSIX
+
+// Applies advice to the pages covering the range, returns false on failure.
+// Populate prefaults writable ranges for writing and others for reading
+inline bool advisePages(const void* data, size_t length, Advice advice, bool writable) noexcept {
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  uint8_t* first = static_cast<uint8_t*>(const_cast<void*>(data));
+  uint8_t* last = first + length;
+  void* begin = reinterpret_cast<void*>(uintptr_t(first) & ~(page_size - 1));
+  size_t size = ((uintptr_t(last) + page_size - 1) & ~(page_size - 1)) - uintptr_t(begin);
+  auto next_page = [](uint8_t* it) {return reinterpret_cast<uint8_t*>((uintptr_t(it) | (page_size - 1)) + 1);};
+  auto populate_read = [&] {
+#ifdef MADV_POPULATE_READ
+    if(!madvise(begin, size, MADV_POPULATE_READ)) return;
+#endif
+    for(uint8_t* it = first; it < last; it = next_page(it)) (void)*static_cast<const volatile uint8_t*>(it);
+  };
+  switch (advice) {
+    case Advice::normal: return !madvise(begin, size, MADV_NORMAL);
+    case Advice::sequential: return !madvise(begin, size, MADV_SEQUENTIAL);
+    case Advice::random: return !madvise(begin, size, MADV_RANDOM);
+    case Advice::will_need: return !madvise(begin, size, MADV_WILLNEED);
+    case Advice::populate:
+      if(!writable) return populate_read(), true;
+#ifdef MADV_POPULATE_WRITE
+      if(!madvise(begin, size, MADV_POPULATE_WRITE)) return true;
+      // Kernels knowing the advices reject ranges that can't be written, EINVAL
+      // from both is a kernel without them
+      if(errno != EINVAL) return populate_read(), false;
+      if(!madvise(begin, size, MADV_POPULATE_READ)) return false;
+      if(errno != EINVAL) return populate_read(), false;
+#endif
+      // Atomic no-op writes fault pages in writable without changing bytes other threads may write
+      for(uint8_t* it = first; it < last; it = next_page(it)) __atomic_fetch_or(it, uint8_t(0), __ATOMIC_RELAXED);
+      return true;
+#ifdef MADV_HUGEPAGE
+    case Advice::huge_pages: return !madvise(begin, size, MADV_HUGEPAGE);
+    case Advice::no_huge_pages: return !madvise(begin, size, MADV_NOHUGEPAGE);
+#else
+    case Advice::huge_pages: case Advice::no_huge_pages: return true;
+#endif
+  }
+  return true;
+}
+
+// Allocation policy mapping blocks of at least Threshold bytes with anonymous mmap.
+// Mapped blocks grow with mremap without copying and return the pages more than
+// Hysteresis bytes past the size to the system as the buffer shrinks
+template<size_t Threshold = size_t(1) << 26, size_t Hysteresis = size_t(1) << 21, typename Base = HeapAllocator>
+class MappedAllocator {
+  static size_t getPageSize() noexcept {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+  }
+
+  // Blocks of huge page size and larger are aligned to it so they can be backed by huge pages
+  static void* map(size_t size, size_t alignment) noexcept {
+    constexpr size_t huge_page_size = size_t(1) << 21;
+    if(size >= huge_page_size && alignment < huge_page_size) alignment = huge_page_size;
+    size_t map_size = alignment > getPageSize() ? size + alignment : size;
+    void* data = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(data == MAP_FAILED) return nullptr;
+    if(map_size == size) return data;
+    uint8_t* begin = static_cast<uint8_t*>(data);
+    uint8_t* aligned = reinterpret_cast<uint8_t*>((reinterpret_cast<uintptr_t>(begin) + alignment - 1) & ~(alignment - 1));
+    size_t tail_offset = (aligned - begin) + ((size + getPageSize() - 1) & ~(getPageSize() - 1));
+    if(aligned != begin) munmap(begin, aligned - begin);
+    if(tail_offset < map_size) munmap(begin + tail_offset, map_size - tail_offset);
+    return aligned;
+  }
+
+public:
+  static bool isMapped(size_t size) noexcept {return size >= Threshold;}
+
+  static void* allocate(size_t size, size_t alignment) noexcept {
+    return isMapped(size) ? map(size, alignment) : Base::allocate(size, alignment);
+  }
+
+  static void* reallocate(void* data, size_t old_size, size_t new_size, size_t alignment) noexcept {
+    if(!isMapped(old_size) && !isMapped(new_size)) return Base::reallocate(data, old_size, new_size, alignment);
+#ifdef __linux__
+    // mremap keeps only page alignment when it moves the block
+    if(isMapped(old_size) && isMapped(new_size) && alignment <= getPageSize()) {
+      void* new_data = mremap(data, old_size, new_size, MREMAP_MAYMOVE);
+      return new_data == MAP_FAILED ? nullptr : new_data;
+    }
+#endif
+    void* new_data = allocate(new_size, alignment);
+    if(!new_data) return nullptr;
+    memcpy(new_data, data, old_size < new_size ? old_size : new_size);
+    deallocate(data, old_size, alignment);
+    return new_data;
+  }
+
+  static void deallocate(void* data, size_t size, size_t alignment) noexcept {
+    if(isMapped(size)) munmap(data, size);
+    else Base::deallocate(data, size, alignment);
+  }
+
+  // Releases up to the capacity, so pages kept in the margin by earlier shrinks go too.
+  // Only shrinks crossing a multiple of the margin call madvise
+  static void release(void* data, size_t capacity, size_t old_size, size_t new_size) noexcept {
+    if(!isMapped(capacity)) return;
+    size_t page_mask = getPageSize() - 1;
+    size_t granule = Hysteresis > page_mask ? Hysteresis : page_mask + 1;
+    if(new_size / granule == old_size / granule) return;
+    size_t from = (new_size + Hysteresis + page_mask) & ~page_mask;
+    size_t to = capacity & ~page_mask;
+    if(from >= to) return;
+    madvise(static_cast<uint8_t*>(data) + from, to - from, MADV_DONTNEED);
+  }
+};
+
+#endif // MEMORYCTRL_POSIX
+
+// Growth policies calculate new capacity of BufferController from
+// the current capacity and the required size
+
+struct Pow2Growth {
+  static size_t getNearestPow2(size_t num) noexcept {
+    num--;
+    num |= num >> 1;
+    num |= num >> 2;
+    num |= num >> 4;
+    num |= num >> 8;
+    num |= num >> 16;
+    num |= num >> 32;
+    num++;
+    return num;
+    // Another option to implement the function:
+    //  *reinterpret_cast<double*>(&num) = num;
+    //  return 1 << (((*(reinterpret_cast<uint32_t*>(&num) + 1) & 0x7FF00000) >> 20) - 1022);
+  }
+
+  static size_t grow(size_t, size_t required) noexcept {return getNearestPow2(required);}
+};
+
+// Multiplies capacity by Numerator/Denominator (1.5 by default)
+template<size_t Numerator = 3, size_t Denominator = 2>
+struct GeometricGrowth {
+  static size_t grow(size_t capacity, size_t required) noexcept {
+    size_t grown = capacity / Denominator * Numerator + capacity % Denominator * Numerator / Denominator;
+    return grown > required ? grown : required;
+  }
+};
+
+// jemalloc-like size classes: four classes per doubling, at most 25% of waste
+struct SizeClassGrowth {
+  static size_t grow(size_t, size_t required) noexcept {
+    if(required <= 16) return Pow2Growth::getNearestPow2(required);
+    size_t step = Pow2Growth::getNearestPow2(required) >> 3;
+    return (required + step - 1) & ~(step - 1);
+  }
+};
+
+// Power of two up to Threshold, then rounding up to a multiple of Step
+template<size_t Threshold = size_t(1) << 20, size_t Step = Threshold>
+struct LinearGrowth {
+  static size_t grow(size_t, size_t required) noexcept {
+    if(required <= Threshold) return Pow2Growth::getNearestPow2(required);
+    return (required + Step - 1) / Step * Step;
+  }
+};
+
+// Per-instance selectable growth, Pow2Growth by default
+class DynamicGrowth {
+public:
+  typedef size_t (*Function)(size_t capacity, size_t required) noexcept;
+private:
+  Function function = &Pow2Growth::grow;
+public:
+  DynamicGrowth(Function function = &Pow2Growth::grow) noexcept : function(function) {}
+  void set(Function function) noexcept {this->function = function;}
+  Function get() const noexcept {return function;}
+  size_t grow(size_t capacity, size_t required) const noexcept {return function(capacity, required);}
+};
+
+// Storage for small-buffer optimization, empty when no inline bytes are requested
+template<size_t InlineBytes, size_t Alignment>
+class InlineStorage {
+  alignas(std::max_align_t) alignas(Alignment) uint8_t inline_data[InlineBytes];
+protected:
+  uint8_t* getInlineData() noexcept {return inline_data;}
+  const uint8_t* getInlineData() const noexcept {return inline_data;}
+};
+
+template<size_t Alignment>
+class InlineStorage<0, Alignment> {
+protected:
+  uint8_t* getInlineData() noexcept {return nullptr;}
+  const uint8_t* getInlineData() const noexcept {return nullptr;}
+};
+
+template<typename Allocator = HeapAllocator, size_t InlineBytes = 0, typename Growth = Pow2Growth,
+         size_t Alignment = alignof (std::max_align_t)>
+class BasicBufferController : InlineStorage<InlineBytes, Alignment>, Growth {
+  static_assert(Alignment && !(Alignment & (Alignment - 1)), "Alignment must be a power of two");
+
+  uint8_t* data = this->getInlineData();
+  size_t size = 0;
+  size_t capacity = InlineBytes;
+
+  size_t grow(size_t required) const noexcept {
+    return static_cast<const Growth&>(*this).grow(capacity, required);
+  }
+
+  // Payloads fitting in InlineBytes stay inside the object
+  void initialize(size_t new_capacity) noexcept {
+    if(new_capacity <= InlineBytes) {
+      data = this->getInlineData();
+      capacity = InlineBytes;
+    } else {
+      data = static_cast<uint8_t*>(Allocator::allocate(new_capacity, Alignment));
+      capacity = new_capacity;
+    }
+  }
+
+  void reallocate(size_t new_capacity) noexcept {
+    if(!new_capacity) return clear();
+    if(new_capacity <= InlineBytes) {
+      if(isInline()) return;
+      memcpy(this->getInlineData(), data, size < new_capacity ? size : new_capacity);
+      Allocator::deallocate(data, capacity, Alignment);
+      data = this->getInlineData();
+      capacity = InlineBytes;
+      return;
+    }
+    if(isInline()) {
+      uint8_t* new_data = static_cast<uint8_t*>(Allocator::allocate(new_capacity, Alignment));
+      memcpy(new_data, data, size);
+      data = new_data;
+    } else {
+      data = static_cast<uint8_t*>(data
+                                   ? Allocator::reallocate(data, capacity, new_capacity, Alignment)
+                                   : Allocator::allocate(new_capacity, Alignment));
+    }
+    capacity = new_capacity;
+  }
+
+public:
+
+  typedef Allocator allocator_type;
+  typedef uint8_t byte;
+  typedef uint8_t* iterator;
+  typedef const uint8_t* const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  BasicBufferController() noexcept = default;
+
+  BasicBufferController(size_t size) noexcept : size(size) {initialize(grow(size));}
+
+  BasicBufferController(const void* buffer, size_t size) noexcept : size(size) {
+    initialize(grow(size));
+    ParallelCopy::copy(data, buffer, size);
+  }
+
+  BasicBufferController(BasicBufferController& other) noexcept : Growth(other), size(other.size) {
+    initialize(other.capacity);
+    if(size) ParallelCopy::copy(data, other.data, size);
+  }
+
+  BasicBufferController(BasicBufferController&& other) noexcept
+    : Growth(other),
+      data(other.data),
+      size(other.size),
+      capacity(other.capacity) {
+    if(other.isInline()) {
+      data = this->getInlineData();
+      memcpy(data, other.data, size);
+    }
+    other.data = other.getInlineData();
+    other.size = 0;
+    other.capacity = InlineBytes;
+  }
+
+  template<typename T>
+  BasicBufferController(std::initializer_list<T> data_list)
+    : size(data_list.size() * sizeof (T)) {
+    initialize(grow(size));
+    T* it = begin<T>();
+    for(auto& element : data_list) {
+      *it = std::move(element);
+      it += sizeof (T);
+    }
+  }
+
+  BasicBufferController(std::initializer_list<BasicBufferController> data_list) {
+    size_t total_size = 0;
+    for(auto& element : data_list) total_size += element.size;
+    initialize(grow(total_size));
+    for(auto& element : data_list) pushBack(std::move(element), static_cast<Error*>(nullptr));
+  }
+
+  ~BasicBufferController() {clear();}
+
+  static BasicBufferController move(const void* buffer, size_t size) noexcept {
+    BasicBufferController ctrl;
+    ctrl.data = (uint8_t*)buffer;
+    ctrl.size = size;
+    ctrl.capacity = size;
+    return ctrl;
+  }
+
+  Growth& getGrowth() noexcept {return *this;}
+  const Growth& getGrowth() const noexcept {return *this;}
+
+  static constexpr size_t getAlignment() noexcept {return Alignment;}
+  bool isAligned(size_t at, size_t alignment) const noexcept {
+    return !(reinterpret_cast<uintptr_t>(data + at) & (alignment - 1));
+  }
+  template<typename T>
+  bool isAligned(size_t at = 0, size_t shift = 0) const noexcept {
+    return isAligned(at * sizeof (T) + shift, alignof (T));
+  }
+
+  bool isEmpty() const noexcept {return !size;}
+  bool isCapacityEmpty() const noexcept {return !data || !capacity;}
+  bool isInline() const noexcept {return InlineBytes && data == this->getInlineData();}
+  void* getData() const noexcept {return data;}
+
+  size_t getSize() const noexcept {return size;}
+  size_t getCapacity() const noexcept {return capacity;}
+  template<typename T>
+  size_t getCount() const noexcept {return size/sizeof(T);}
+  template<typename T>
+  size_t getCapacity() const noexcept {return capacity/sizeof (T);}
+
+  void clear() noexcept {
+    if(data && !isInline()) Allocator::deallocate(data, capacity, Alignment);
+    data = this->getInlineData();
+    size = 0;
+    capacity = InlineBytes;
+  }
+
+  void resize(size_t new_size) noexcept {
+    if(size == new_size) return;
+    else if(size >= new_size || capacity >= new_size) {
+      if constexpr (HasRelease<Allocator>::value)
+        if(new_size < size && !isInline()) Allocator::release(data, capacity, size, new_size);
+      size = new_size;
+      return;
+    } else {
+      reallocate(grow(new_size));
+      size = new_size;
+      return;
+    }
+  }
+
+  template<typename T>
+  void resize(size_t count) noexcept {return resize(count * sizeof(T));}
+
+  void reserve(size_t new_capacity) noexcept {
+    if(capacity >= new_capacity) return;
+    reallocate(grow(new_capacity));
+    if(capacity < size) size = capacity;
+  }
+
+  template<typename T>
+  void reserve(size_t count) noexcept {return reserve(count * sizeof (T));}
+
+  // Reserves capacity and applies advice to the whole block before it is touched
+  void reserve(size_t new_capacity, Advice advice, Error* err = nullptr) noexcept {
+    reserve(new_capacity);
+    advise(advice, err);
+  }
+
+  void advise(Advice advice, Error* err = nullptr) const noexcept {return advise(advice, 0, capacity, err);}
+
+  // Hints are applied to whole pages covering the range
+  void advise(Advice advice, size_t at, size_t length, Error* err = nullptr) const noexcept {
+    if(at + length > capacity) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    if(!length || isInline()) return;
+#ifdef MEMORYCTRL_POSIX
+    if(!advisePages(data + at, length, advice, true) && err) *err = ErrorType::system_error;
+#else
+    (void)advice;
+#endif
+  }
+
+  void shrinkToFit() noexcept {
+    if(size == capacity) return;
+    reallocate(size);
+  }
+
+  void subSizeBack(size_t sub) noexcept {return resize(size - sub);}
+
+  void subSizeFront(size_t sub) noexcept {
+    ParallelCopy::move(data, data + sub, size - sub);
+    return resize(size - sub);
+  }
+
+  void subSizeFrom(size_t at, size_t sub) noexcept {
+    ParallelCopy::move(data + at, data + at + sub, size - sub - at);
+    return resize(size - sub);
+  }
+
+  iterator addSizeToBack(size_t add) noexcept {
+    size_t old_size = size;
+    resize(size + add);
+    return data + old_size;
+  }
+
+  iterator addSizeToFront(size_t add) noexcept {
+    size_t old_size = size;
+    addSizeToBack(add);
+    ParallelCopy::move(data + add, data, old_size);
+    return data;
+  }
+
+  iterator addSizeTo(size_t to, size_t add) noexcept {
+    size_t old_size = size;
+    addSizeToBack(add);
+    iterator it = data + to;
+    ParallelCopy::move(it + add, it, old_size - to);
+    return it;
+  }
+
+  iterator pushBack(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    // Source may point into this buffer and move on reallocation
+    if(data >= this->data && data < this->data + this->size) {
+      size_t offset = static_cast<const uint8_t*>(data) - this->data;
+      auto data_it = addSizeToBack(size);
+      ParallelCopy::move(data_it, this->data + offset, size);
+      return data_it;
+    }
+    auto data_it = addSizeToBack(size);
+    ParallelCopy::move(data_it, data, size);
+    return data_it;
+  }
+
+  iterator insert(size_t to, const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    if(to > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return end();
+    }
+    auto data_it = addSizeTo(to, size);
+    ParallelCopy::move(data_it, data, size);
+    return data_it;
+  }
+
+  iterator pushFront(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    auto data_it = addSizeToFront(size);
+    ParallelCopy::move(data_it, data, size);
+    return data_it;
+  }
+
+  // Streaming variants write around the cache, for large data which isn't read back soon.
+  // Plain fill uses memset, which libc already vectorizes
+
+  iterator streamPushBack(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    if(data >= this->data && data < this->data + this->size) return pushBack(data, size, err);
+    auto data_it = addSizeToBack(size);
+    simd::streamCopy(data_it, data, size);
+    return data_it;
+  }
+
+  // Overwrites bytes starting at at
+  iterator copyFrom(size_t at, const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return end();
+    }
+    ParallelCopy::move(this->data + at, data, size);
+    return this->data + at;
+  }
+
+  iterator streamCopyFrom(size_t at, const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return end();
+    }
+    const uint8_t* source = static_cast<const uint8_t*>(data);
+    if(source < this->data + at + size && this->data + at < source + size) memmove(this->data + at, data, size);
+    else simd::streamCopy(this->data + at, data, size);
+    return this->data + at;
+  }
+
+  void fill(byte value) noexcept {memset(data, value, size);}
+
+  void fill(byte value, size_t at, size_t size, Error* err = nullptr) noexcept {
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    memset(data + at, value, size);
+  }
+
+  void streamFill(byte value) noexcept {simd::streamFill(data, size, value);}
+
+  void streamFill(byte value, size_t at, size_t size, Error* err = nullptr) noexcept {
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    simd::streamFill(data + at, size, value);
+  }
+
+  void zero() noexcept {fill(0);}
+
+  iterator pushBack(const BasicBufferController& other, Error* err = nullptr) noexcept {
+    return pushBack(other.data, other.size, err);
+  }
+
+  iterator pushBack(BasicBufferController&& other, Error* err = nullptr) noexcept {
+    return pushBack(other.data, other.size, err);
+  }
+
+  iterator insert(size_t to, const BasicBufferController& other, Error* err = nullptr) noexcept {
+    return insert(to, other.data, other.size, err);
+  }
+
+  iterator insert(size_t to, BasicBufferController&& other, Error* err = nullptr) noexcept {
+    return insert(to, other.data, other.size, err);
+  }
+
+  iterator pushFront(const BasicBufferController& other, Error* err = nullptr) noexcept {
+    return pushFront(other.data, other.size, err);
+  }
+
+  iterator pushFront(BasicBufferController&& other, Error* err = nullptr) noexcept {
+    return pushFront(other.data, other.size, err);
+  }
+
+  template<typename T, typename... Args>
+  T* emplaceBack(Args&&... args) noexcept {
+    return reinterpret_cast<T*>(new (addSizeToBack(sizeof (T))) T(std::forward<Args>(args)...));
+  }
+
+  template<typename T, typename... Args>
+  T* emplaceAt(size_t index, size_t shift, Args&&... args, Error* err = nullptr) noexcept {
+    if((index * sizeof (T) + shift) > size) {
+      if(err) *err = ErrorType::out_of_range;
+      return end<T>();
+    }
+    return reinterpret_cast<T*>(new (addSizeTo(index * sizeof (T) + shift, sizeof (T))) T(std::forward<Args>(args)...));
+  }
+
+  template<typename T, typename... Args>
+  T* emplaceFront(Args&&... args) noexcept {
+    return reinterpret_cast<T*>(new (addSizeToFront(sizeof (T))) T(std::forward<Args>(args)...));
+  }
+
+  template<typename T>
+  void destruct(size_t at, size_t shift, size_t count = 1, Error* err = nullptr) noexcept {
+    if((at * sizeof (T) + shift + count * sizeof (T)) >= size) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    for(T* it = reinterpret_cast<T*>(data + shift) + at,
+        * end = reinterpret_cast<T*>(data + shift) + at + count;
+        it != end; ++it)
+      it->~T();
+  }
+
+  template<typename T>
+  void destructFirst() noexcept {
+    return destruct<T>(0, 0, 1, nullptr);
+  }
+
+  template<typename T>
+  void destructLast() noexcept {
+    return destruct<T>(getCount<T>() - 1, 0, 1, nullptr);
+  }
+
+  template<typename T>
+  void destructAll() noexcept {
+    return destruct<T>(0, 0, getCount<T>(), nullptr);
+  }
+
+  // Buffers passed as typed values are appended as raw bytes and return this controller
+  template<typename T>
+  T* pushBack(const T& value) noexcept {
+    if constexpr (std::is_same_v<T, BasicBufferController>) {
+      pushBack(value, static_cast<Error*>(nullptr));
+      return this;
+    } else return reinterpret_cast<T*>(pushBack(&value, sizeof (T)));
+  }
+
+  template<typename T>
+  T* pushBack(T&& value) noexcept {
+    if constexpr (std::is_same_v<std::remove_const_t<T>, BasicBufferController>) {
+      pushBack(value.data, value.size, static_cast<Error*>(nullptr));
+      return this;
+    } else return emplaceBack<T>(std::move(value));
+  }
+
+  template<typename T>
+  T* insert(size_t index, size_t shift, const T& value, Error* err = nullptr) noexcept {
+    if constexpr (std::is_same_v<T, BasicBufferController>) {
+      insert(index + shift, value.data, value.size, err);
+      return this;
+    } else return reinterpret_cast<T*>(insert(index * sizeof (T) + shift, &value, sizeof (T), err));
+  }
+
+  template<typename T>
+  T* insert(size_t index, size_t shift, T&& value, Error* err = nullptr) noexcept {
+    if constexpr (std::is_same_v<std::remove_const_t<T>, BasicBufferController>) {
+      insert(index + shift, value.data, value.size, err);
+      return this;
+    } else return emplaceAt<T>(index, shift, std::move(value), err);
+  }
+
+  template<typename T>
+  T* pushFront(const T& value) noexcept {
+    if constexpr (std::is_same_v<T, BasicBufferController>) {
+      pushFront(value, static_cast<Error*>(nullptr));
+      return this;
+    } else return reinterpret_cast<T*>(pushFront(&value, sizeof (T)));
+  }
+
+  template<typename T>
+  T* pushFront(T&& value) noexcept {
+    if constexpr (std::is_same_v<std::remove_const_t<T>, BasicBufferController>) {
+      pushFront(value.data, value.size, static_cast<Error*>(nullptr));
+      return this;
+    } else return emplaceFront<T>(std::move(value));
+  }
+
+  void remove(size_t at, size_t count = 1, Error* err = nullptr) noexcept {
+    if(!at && count == size) return resize(0);
+    if(at + count > size) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    memmove(data + at, data + at + size, size - count - at);
+    subSizeBack(at);
+  }
+
+  template<typename T>
+  void remove(size_t at, size_t shift, size_t count = 1, Error* err = nullptr) noexcept {
+    return remove(at * sizeof(T) + shift, count, err);
+  }
+
+  byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= size) {
+      if(err) *err = ErrorType::out_of_range;
+      return data[size - 1];
+    }
+    return data[at];
+  }
+
+  template<typename T>
+  T& get(size_t at, size_t shift, Error* err = nullptr) const noexcept {
+    return *reinterpret_cast<T*>(&get(at * sizeof (T) + shift, err));
+  }
+
+  byte& first(Error* err = nullptr) const noexcept {
+    if(!size) {
+      if(err) *err = ErrorType::null_ponter;
+      return get(0);
+    }
+    return get(0);
+  }
+
+  template<typename T>
+  T& first(Error* err = nullptr) const noexcept {
+    if(!size) {
+      if(err) *err = ErrorType::null_ponter;
+      return get<T>(0,0);
+    }
+    return get<T>(0,0);
+  }
+
+  byte& last(Error* err = nullptr) const noexcept {
+    if(!size) {
+      if(err) *err = ErrorType::null_ponter;
+      return get(0);
+    }
+    return get(size - 1);
+  }
+
+  template<typename T>
+  T& last(Error* err = nullptr) const noexcept {
+    if(!size) {
+      if(err) *err = ErrorType::null_ponter;
+      return get<T>(0,0);
+    }
+    return get<T>(getCount<T>() - 1, 0);
+  }
+
+  BasicBufferController takeBack(size_t size, Error* err) noexcept {
+    if(!this->size) {
+      if(err) *err = ErrorType::null_ponter;
+      return BasicBufferController();
+    }
+    if(size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BasicBufferController();
+    }
+    BasicBufferController new_data(size);
+    ParallelCopy::copy(new_data.data, end() - size, size);
+    subSizeBack(size);
+    return new_data;
+  }
+
+  BasicBufferController takeFront(size_t size, Error* err) noexcept {
+    if(!this->size) {
+      if(err) *err = ErrorType::null_ponter;
+      return BasicBufferController();
+    }
+    if(size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BasicBufferController();
+    }
+    BasicBufferController new_data(size);
+    ParallelCopy::copy(new_data.data, data, size);
+    subSizeFront(size);
+    return new_data;
+  }
+
+  BasicBufferController takeFrom(size_t at, size_t size, Error* err) noexcept {
+    if(!this->size) {
+      if(err) *err = ErrorType::null_ponter;
+      return BasicBufferController();
+    }
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BasicBufferController();
+    }
+    BasicBufferController new_data(size);
+    ParallelCopy::copy(new_data.data, data + at, size);
+    subSizeFrom(at, size);
+    return new_data;
+  }
+
+#ifdef MEMORYCTRL_POSIX
+  // Written bytes are removed from the front
+  size_t writeTo(int fd, Error* err = nullptr) noexcept {
+    BufferView unwritten = view();
+    size_t written = unwritten.writeTo(fd, err);
+    subSizeFront(written);
+    return written;
+  }
+
+  // Appends up to size bytes read with a single read call
+  size_t readFrom(int fd, size_t size, Error* err = nullptr) noexcept {
+    iterator it = addSizeToBack(size);
+    ssize_t result;
+    do result = read(fd, it, size);
+    while(result < 0 && errno == EINTR);
+    if(result < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK && err) *err = ErrorType::system_error;
+      result = 0;
+    }
+    subSizeBack(size - result);
+    return result;
+  }
+#endif
+
+  BufferView view() const noexcept {return BufferView(data, size);}
+
+  template<typename T>
+  TypedView<T> view() const noexcept {return TypedView<T>(begin<T>(), getCount<T>());}
+
+  BufferView view(size_t at, size_t size, Error* err = nullptr) const noexcept {
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    return BufferView(data + at, size);
+  }
+
+  // Taken bytes stay in place behind the new size, the view is valid until the buffer grows
+  BufferView takeBackView(size_t size, Error* err = nullptr) noexcept {
+    if(size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    // Skips the allocator release hook, it could drop the pages under the view
+    this->size -= size;
+    return BufferView(end(), size);
+  }
+
+  iterator begin() const noexcept {return data;}
+  iterator end() const noexcept {return data + size;}
+
+  iterator cbegin() const noexcept {return data;}
+  iterator cend() const noexcept {return data + size;}
+
+  reverse_iterator rbegin() const noexcept {return reverse_iterator(data + size - 1);}
+  reverse_iterator rend() const noexcept {return reverse_iterator(data - 1);}
+
+  const_reverse_iterator crbegin() const noexcept {return const_reverse_iterator(data + size - 1);}
+  const_reverse_iterator crend() const noexcept {return const_reverse_iterator(data - 1);}
+
+  template<typename T>
+  T* begin() const noexcept {return reinterpret_cast<T*>(data);}
+  template<typename T>
+  T* end() const noexcept {return reinterpret_cast<T*>(data) + getCount<T>();}
+
+  template<typename T>
+  const T* cbegin() const noexcept {return reinterpret_cast<T*>(data);}
+  template<typename T>
+  const T* cend() const noexcept {return reinterpret_cast<T*>(data) + getCount<T>();}
+
+  template<typename T>
+  std::reverse_iterator<T*> rbegin() const noexcept {
+    return std::reverse_iterator<T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) + getCount<T>() - 1));
+  }
+  template<typename T>
+  std::reverse_iterator<T*> rend() const noexcept {
+    return std::reverse_iterator<T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) - 1));
+  }
+
+  template<typename T>
+  std::reverse_iterator<const T*> crbegin() const noexcept {
+    return std::reverse_iterator<const T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) + getCount<T>() - 1));
+  }
+  template<typename T>
+  std::reverse_iterator<const T*> crend() const noexcept {
+    return std::reverse_iterator<const T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) - 1));
+  }
+
+  byte& operator[](size_t index) const noexcept {return get(index);}
+
+  BasicBufferController& operator+=(const BasicBufferController& other) noexcept {
+    pushBack(other);
+    return *this;
+  }
+
+  BasicBufferController operator+=(BasicBufferController&& other) noexcept {
+    pushBack(std::move(other));
+    return *this;
+  }
+
+  BasicBufferController operator+(const BasicBufferController& other) noexcept {
+    BasicBufferController tmp(*this);
+    tmp.pushBack(other);
+    return tmp;
+  }
+
+  BasicBufferController operator+(BasicBufferController&& other) noexcept {
+    BasicBufferController tmp(*this);
+    tmp.pushBack(std::move(other));
+    return tmp;
+  }
+
+  BasicBufferController& operator=(const BasicBufferController& other) noexcept {
+    resize(0);
+    pushBack(other);
+    return *this;
+  }
+
+  BasicBufferController operator=(BasicBufferController&& other) noexcept {
+    resize(0);
+    pushBack(std::move(other));
+    return *this;
+  }
+
+  // Index of the first different byte, the smaller size if one buffer is a prefix of another
+  size_t firstMismatch(const BasicBufferController& other) const noexcept {
+    return simd::firstMismatch(data, other.data, size < other.size ? size : other.size);
+  }
+
+  int compare(const BasicBufferController& other) const noexcept {
+    return simd::compare(data, size, other.data, other.size);
+  }
+
+  bool operator==(const BasicBufferController& other) const noexcept {
+    return size == other.size && simd::isEqual(data, other.data, size);
+  }
+
+  bool operator!=(const BasicBufferController& other) const noexcept {return !(*this == other);}
+  bool operator<(const BasicBufferController& other) const noexcept {return compare(other) < 0;}
+
+  // Search functions return the index of the first match or size if nothing is found
+  size_t find(byte value, size_t from = 0) const noexcept {return view().find(value, from);}
+  size_t find(const void* needle, size_t needle_size, size_t from = 0) const noexcept {return view().find(needle, needle_size, from);}
+  size_t find(const BufferView& needle, size_t from = 0) const noexcept {return view().find(needle, from);}
+  size_t findAny(const void* set, size_t set_size, size_t from = 0) const noexcept {return view().findAny(set, set_size, from);}
+  size_t findAny(const BufferView& set, size_t from = 0) const noexcept {return view().findAny(set, from);}
+  size_t count(byte value) const noexcept {return view().count(value);}
+
+  uint32_t crc32c(uint32_t crc = 0) const noexcept {return simd::crc32c(data, size, crc);}
+  uint64_t xxhash64(uint64_t seed = 0) const noexcept {return memctrl::xxhash64(data, size, seed);}
+
+  std::vector<BufferView> split(byte delimiter) const {return view().split(delimiter);}
+  std::vector<BufferView> split(const BufferView& delimiter) const {return view().split(delimiter);}
+
+};
+
+
+typedef BasicBufferController<> BufferController;
+typedef BasicBufferController<RecyclingAllocator<>> RecyclingBufferController;
+template<size_t InlineBytes>
+using SmallBufferController = BasicBufferController<HeapAllocator, InlineBytes>;
+
+#ifdef MEMORYCTRL_POSIX
+
+// Read-only buffer over a whole file mapped with mmap, the mapping is released with
+// the controller. Pages come from the page cache on first access, so large files
+// map instantly and are never charged against the commit limit
+class MappedFileController {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+
+  bool open(const char* path, Error* err) noexcept {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    struct stat file_stat;
+    if(fd < 0 || fstat(fd, &file_stat)) {
+      if(err) *err = ErrorType::system_error;
+      if(fd >= 0) ::close(fd);
+      return false;
+    }
+    size_t file_size = file_stat.st_size;
+    void* mapping = file_size ? mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    ::close(fd);
+    if(mapping == MAP_FAILED) {
+      if(err) *err = ErrorType::system_error;
+      return false;
+    }
+    data = static_cast<const uint8_t*>(mapping);
+    size = file_size;
+    return true;
+  }
+
+public:
+
+  typedef uint8_t byte;
+  typedef const uint8_t* iterator;
+  typedef const uint8_t* const_iterator;
+
+  MappedFileController() noexcept = default;
+  MappedFileController(const char* path, Error* err = nullptr) noexcept {open(path, err);}
+
+  MappedFileController(MappedFileController&& other) noexcept : data(other.data), size(other.size) {
+    other.data = nullptr;
+    other.size = 0;
+  }
+
+  MappedFileController& operator=(MappedFileController&& other) noexcept {
+    if(this == &other) return *this;
+    close();
+    data = other.data;
+    size = other.size;
+    other.data = nullptr;
+    other.size = 0;
+    return *this;
+  }
+
+  MappedFileController(const MappedFileController&) = delete;
+  MappedFileController& operator=(const MappedFileController&) = delete;
+
+  ~MappedFileController() {close();}
+
+  void close() noexcept {
+    if(data) munmap(const_cast<uint8_t*>(data), size);
+    data = nullptr;
+    size = 0;
+  }
+
+  bool isEmpty() const noexcept {return !size;}
+  const void* getData() const noexcept {return data;}
+  size_t getSize() const noexcept {return size;}
+  template<typename T>
+  size_t getCount() const noexcept {return size/sizeof (T);}
+
+  const byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= size) {
+      if(err) *err = ErrorType::out_of_range;
+      return data[size - 1];
+    }
+    return data[at];
+  }
+
+  template<typename T>
+  const T& get(size_t at, size_t shift, Error* err = nullptr) const noexcept {
+    return *reinterpret_cast<const T*>(&get(at * sizeof (T) + shift, err));
+  }
+
+  // Writing through the view faults, the mapping is read-only
+  BufferView view() const noexcept {return BufferView(data, size);}
+
+  template<typename T>
+  TypedView<const T> as() const noexcept {return TypedView<const T>(begin<T>(), getCount<T>());}
+
+  // Populate faults pages in for reading, the file is never written
+  void advise(Advice advice, Error* err = nullptr) const noexcept {return advise(advice, 0, size, err);}
+
+  void advise(Advice advice, size_t at, size_t length, Error* err = nullptr) const noexcept {
+    if(at + length > size) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    if(length && !advisePages(data + at, length, advice, false) && err) *err = ErrorType::system_error;
+  }
+
+  iterator begin() const noexcept {return data;}
+  iterator end() const noexcept {return data + size;}
+
+  template<typename T>
+  const T* begin() const noexcept {return reinterpret_cast<const T*>(data);}
+  template<typename T>
+  const T* end() const noexcept {return reinterpret_cast<const T*>(data) + getCount<T>();}
+
+  const byte& operator[](size_t index) const noexcept {return data[index];}
+};
+
+// Maps the whole file read-only
+inline MappedFileController mapFile(const char* path, Error* err = nullptr) noexcept {
+  return MappedFileController(path, err);
+}
+
+// Growable buffer persisted in a file through a shared mapping. The file starts
+// with a header holding the size of the payload, so reopening the file restores
+// the buffer without reading it. Writes reach the file on writeback or flush
+template<typename Growth = Pow2Growth>
+class BasicFileController {
+  struct Header {
+    uint64_t magic;
+    uint64_t size;
+  };
+
+  static constexpr uint64_t file_magic = 0x4C5254434D454D31; // "1MEMCTRL"
+  // Keeps the payload aligned to a cache line
+  static constexpr size_t header_size = 64;
+
+  int fd = -1;
+  uint8_t* mapping = nullptr;
+  size_t capacity = 0;
+  bool sync_on_commit = false;
+
+  Header& getHeader() const noexcept {return *reinterpret_cast<Header*>(mapping);}
+
+  // The size is stored last, so bytes it covers are written before it
+  void publishSize(size_t new_size) noexcept {__atomic_store_n(&getHeader().size, new_size, __ATOMIC_RELEASE);}
+
+  // Offsets are relative to the mapping
+  bool sync(size_t from, size_t to) const noexcept {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    from &= ~(page_size - 1);
+    return from >= to || !msync(mapping + from, to - from, MS_SYNC);
+  }
+
+  bool remap(size_t new_capacity, Error* err) noexcept {
+    if(ftruncate(fd, header_size + new_capacity)) {
+      if(err) *err = ErrorType::system_error;
+      return false;
+    }
+#ifdef __linux__
+    void* new_mapping = mremap(mapping, header_size + capacity, header_size + new_capacity, MREMAP_MAYMOVE);
+#else
+    munmap(mapping, header_size + capacity);
+    void* new_mapping = mmap(nullptr, header_size + new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+    if(new_mapping == MAP_FAILED) {
+      if(err) *err = ErrorType::system_error;
+      return false;
+    }
+    mapping = static_cast<uint8_t*>(new_mapping);
+    capacity = new_capacity;
+    return true;
+  }
+
+  bool open(const char* path, Error* err) noexcept {
+    fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat file_stat;
+    if(fd < 0 || fstat(fd, &file_stat)) {
+      if(err) *err = ErrorType::system_error;
+      return false;
+    }
+    size_t file_size = file_stat.st_size;
+    if(file_size && file_size < header_size) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    bool created = !file_size;
+    if(created && ftruncate(fd, file_size = header_size)) {
+      if(err) *err = ErrorType::system_error;
+      return false;
+    }
+    void* new_mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(new_mapping == MAP_FAILED) {
+      if(err) *err = ErrorType::system_error;
+      return false;
+    }
+    mapping = static_cast<uint8_t*>(new_mapping);
+    capacity = file_size - header_size;
+    Header& header = getHeader();
+    // Only an empty file is adopted, any other file must carry the magic
+    if(created) {
+      header.size = 0;
+      header.magic = file_magic;
+    } else if(header.magic != file_magic || header.size > capacity) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    return true;
+  }
+
+public:
+
+  typedef uint8_t byte;
+  typedef uint8_t* iterator;
+
+  BasicFileController() noexcept = default;
+
+  // Opens or creates the file, an existing file must have been written by this class
+  BasicFileController(const char* path, Error* err = nullptr) noexcept {if(!open(path, err)) close();}
+
+  BasicFileController(BasicFileController&& other) noexcept
+    : fd(other.fd), mapping(other.mapping), capacity(other.capacity), sync_on_commit(other.sync_on_commit) {
+    other.fd = -1;
+    other.mapping = nullptr;
+    other.capacity = 0;
+  }
+
+  BasicFileController& operator=(BasicFileController&& other) noexcept {
+    if(this == &other) return *this;
+    close();
+    fd = other.fd;
+    mapping = other.mapping;
+    capacity = other.capacity;
+    sync_on_commit = other.sync_on_commit;
+    other.fd = -1;
+    other.mapping = nullptr;
+    other.capacity = 0;
+    return *this;
+  }
+
+  BasicFileController(const BasicFileController&) = delete;
+  BasicFileController& operator=(const BasicFileController&) = delete;
+
+  ~BasicFileController() {close();}
+
+  // Unmaps and closes the file, the kernel still writes back dirty pages
+  void close() noexcept {
+    if(mapping) munmap(mapping, header_size + capacity);
+    if(fd >= 0) ::close(fd);
+    fd = -1;
+    mapping = nullptr;
+    capacity = 0;
+  }
+
+  bool isOpen() const noexcept {return mapping;}
+  bool isEmpty() const noexcept {return !getSize();}
+  void* getData() const noexcept {return begin();}
+  size_t getSize() const noexcept {return mapping ? __atomic_load_n(&getHeader().size, __ATOMIC_ACQUIRE) : 0;}
+  size_t getCapacity() const noexcept {return capacity;}
+  template<typename T>
+  size_t getCount() const noexcept {return getSize()/sizeof (T);}
+
+  void reserve(size_t new_capacity, Error* err = nullptr) noexcept {
+    if(!mapping) {
+      if(err) *err = ErrorType::null_ponter;
+      return;
+    }
+    if(capacity >= new_capacity) return;
+    remap(Growth().grow(capacity, new_capacity), err);
+  }
+
+  // Commits synchronize written pages to the file before the size is stored and
+  // the header after it, so the file survives a system crash, not only a process crash
+  void setSyncOnCommit(bool sync) noexcept {sync_on_commit = sync;}
+  bool isSyncOnCommit() const noexcept {return sync_on_commit;}
+
+  // Grows the file when the capacity is exceeded, the size is stored in the header
+  // after the mapping grows
+  void resize(size_t new_size, Error* err = nullptr) noexcept {
+    Error reserve_err;
+    reserve(new_size, &reserve_err);
+    if(reserve_err) {
+      if(err) *err = reserve_err;
+      return;
+    }
+    publishSize(new_size);
+  }
+
+  void shrinkToFit(Error* err = nullptr) noexcept {
+    if(!mapping || capacity == getSize()) return;
+    remap(getSize(), err);
+  }
+
+  void subSizeBack(size_t sub) noexcept {
+    if(!mapping) return;
+    publishSize(getSize() - (sub > getSize() ? getSize() : sub));
+  }
+
+  // Space of add bytes after the payload, not counted in the size until commitBack
+  iterator reserveBack(size_t add, Error* err = nullptr) noexcept {
+    Error reserve_err;
+    reserve(getSize() + add, &reserve_err);
+    if(reserve_err) {
+      if(err) *err = reserve_err;
+      return nullptr;
+    }
+    return end();
+  }
+
+  // Adds written bytes after the payload to the size
+  void commitBack(size_t add, Error* err = nullptr) noexcept {
+    size_t old_size = getSize();
+    if(old_size + add > capacity) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    if(sync_on_commit && !sync(header_size + old_size, header_size + old_size + add)) {
+      if(err) *err = ErrorType::system_error;
+      return;
+    }
+    publishSize(old_size + add);
+    if(sync_on_commit && !sync(0, header_size) && err) *err = ErrorType::system_error;
+  }
+
+  // The size covers the bytes before they are written, reserveBack and commitBack
+  // keep a crash from leaving unwritten bytes in the payload
+  iterator addSizeToBack(size_t add, Error* err = nullptr) noexcept {
+    size_t old_size = getSize();
+    Error resize_err;
+    resize(old_size + add, &resize_err);
+    if(resize_err) {
+      if(err) *err = resize_err;
+      return nullptr;
+    }
+    return begin() + old_size;
+  }
+
+  iterator pushBack(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return nullptr;
+    }
+    // Source may point into the mapping and move on remap
+    bool is_inside = data >= begin() && data < end();
+    size_t offset = is_inside ? static_cast<const uint8_t*>(data) - begin() : 0;
+    iterator it = reserveBack(size, err);
+    if(!it) return nullptr;
+    memmove(it, is_inside ? begin() + offset : data, size);
+    commitBack(size, err);
+    return it;
+  }
+
+  template<typename T>
+  T* pushBack(const T& value, Error* err = nullptr) noexcept {
+    return reinterpret_cast<T*>(pushBack(&value, sizeof (T), err));
+  }
+
+  // Synchronously writes the pages of the range and the header to the file
+  void flush(size_t at, size_t size, Error* err = nullptr) const noexcept {
+    if(!mapping) {
+      if(err) *err = ErrorType::null_ponter;
+      return;
+    }
+    if(at + size > capacity) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    if(!sync(header_size + at, header_size + at + size) || !sync(0, header_size))
+      if(err) *err = ErrorType::system_error;
+  }
+
+  void flush(Error* err = nullptr) const noexcept {return flush(0, getSize(), err);}
+
+  byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return *(end() - 1);
+    }
+    return begin()[at];
+  }
+
+  template<typename T>
+  T& get(size_t at, size_t shift, Error* err = nullptr) const noexcept {
+    return *reinterpret_cast<T*>(&get(at * sizeof (T) + shift, err));
+  }
+
+  BufferView view() const noexcept {return BufferView(begin(), getSize());}
+
+  iterator begin() const noexcept {return mapping ? mapping + header_size : nullptr;}
+  iterator end() const noexcept {return begin() + getSize();}
+
+  template<typename T>
+  T* begin() const noexcept {return reinterpret_cast<T*>(begin());}
+  template<typename T>
+  T* end() const noexcept {return reinterpret_cast<T*>(begin()) + getCount<T>();}
+
+  byte& operator[](size_t index) const noexcept {return get(index);}
+};
+
+typedef BasicFileController<> FileController;
+
+// Asynchronous reads into and writes from buffer ranges. Requests go to io_uring
+// when the kernel allows it, otherwise to a pool of threads calling pread/pwrite.
+// Callbacks and futures are completed by poll/wait on the calling thread,
+// ranges must stay valid and untouched until their request is completed
+class AsyncIO {
+public:
+  // Count of transferred bytes or negated errno
+  typedef std::function<void(ssize_t result)> Callback;
+
+private:
+  enum class Operation {read, write};
+
+  struct Request {
+    Operation operation;
+    int fd;
+    iovec range;
+    off_t offset;
+    Callback callback;
+    ssize_t result = 0;
+  };
+
+  // Requests handed to the ring or to the thread pool and not completed yet
+  size_t in_flight = 0;
+
+#ifdef MEMORYCTRL_IO_URING
+  // Requests waiting for room in the submission or completion queue
+  std::deque<Request*> deferred;
+  int ring_fd = -1;
+  void* sq_map = nullptr;
+  void* cq_map = nullptr;
+  size_t sq_map_size = 0;
+  size_t cq_map_size = 0;
+  io_uring_sqe* sqes = nullptr;
+  size_t sqes_size = 0;
+  unsigned* sq_head = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned* sq_mask = nullptr;
+  unsigned* sq_array = nullptr;
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned* cq_mask = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  unsigned sq_entries = 0;
+  unsigned cq_entries = 0;
+  unsigned unsubmitted = 0;
+
+  bool setupRing(unsigned queue_depth) noexcept {
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+    ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+    if(ring_fd < 0) return false;
+    sq_map_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+    bool single_map = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single_map) sq_map_size = cq_map_size = sq_map_size > cq_map_size ? sq_map_size : cq_map_size;
+    sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+    sq_map = mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    cq_map = single_map ? sq_map : mmap(nullptr, cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    void* sqes_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if(sq_map == MAP_FAILED || cq_map == MAP_FAILED || sqes_map == MAP_FAILED) {
+      if(sqes_map != MAP_FAILED) munmap(sqes_map, sqes_size);
+      if(cq_map != MAP_FAILED && cq_map != sq_map) munmap(cq_map, cq_map_size);
+      if(sq_map != MAP_FAILED) munmap(sq_map, sq_map_size);
+      sq_map = cq_map = nullptr;
+      close(ring_fd);
+      ring_fd = -1;
+      return false;
+    }
+    uint8_t* sq = static_cast<uint8_t*>(sq_map);
+    uint8_t* cq = static_cast<uint8_t*>(cq_map);
+    sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    sqes = static_cast<io_uring_sqe*>(sqes_map);
+    sq_entries = params.sq_entries;
+    cq_entries = params.cq_entries;
+    return true;
+  }
+
+  void closeRing() noexcept {
+    if(ring_fd < 0) return;
+    munmap(sqes, sqes_size);
+    if(cq_map != sq_map) munmap(cq_map, cq_map_size);
+    munmap(sq_map, sq_map_size);
+    close(ring_fd);
+    ring_fd = -1;
+  }
+
+  int enterRing(unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+    int result;
+    do result = syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+    while(result < 0 && errno == EINTR);
+    return result;
+  }
+
+  // Places the request into the submission queue, returns false if there is no room.
+  // Completion queue can't overflow while requests in flight fit into it
+  bool placeRing(Request* request) noexcept {
+    if(in_flight >= cq_entries) return false;
+    unsigned tail = *sq_tail;
+    if(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == sq_entries) {
+      // Slots are reused only after the kernel consumed them
+      submitRing();
+      if(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) == sq_entries) return false;
+    }
+    unsigned index = tail & *sq_mask;
+    io_uring_sqe& sqe = sqes[index];
+    memset(&sqe, 0, sizeof sqe);
+    sqe.opcode = request->operation == Operation::read ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe.fd = request->fd;
+    sqe.addr = reinterpret_cast<uint64_t>(&request->range);
+    sqe.len = 1;
+    sqe.off = request->offset;
+    sqe.user_data = reinterpret_cast<uint64_t>(request);
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++unsubmitted;
+    ++in_flight;
+    return true;
+  }
+
+  // Never blocks, so it is safe to call from a completion callback
+  void queueRing(Request* request) noexcept {
+    if(deferred.empty() && placeRing(request)) return;
+    deferred.push_back(request);
+  }
+
+  bool submitRing() noexcept {
+    if(!unsubmitted) return true;
+    int result = enterRing(unsubmitted, 0, 0);
+    if(result < 0) return false;
+    unsubmitted -= result;
+    return true;
+  }
+
+  void placeDeferred() noexcept {
+    while(!deferred.empty() && placeRing(deferred.front())) deferred.pop_front();
+  }
+
+  // Completion queue entries are consumed before any callback runs,
+  // so callbacks may queue new requests or wait themselves
+  size_t reapRing() {
+    std::vector<Request*> finished;
+    unsigned head = *cq_head;
+    unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    for(; head != tail; ++head) {
+      io_uring_cqe& cqe = cqes[head & *cq_mask];
+      Request* request = reinterpret_cast<Request*>(cqe.user_data);
+      request->result = cqe.res;
+      finished.push_back(request);
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    in_flight -= finished.size();
+    placeDeferred();
+    for(Request* request : finished) complete(request);
+    return finished.size();
+  }
+#endif
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable task_condition;
+  std::condition_variable completion_condition;
+  std::deque<Request*> tasks;
+  std::vector<Request*> completions;
+  bool stopping = false;
+
+  void work() noexcept {
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true) {
+      task_condition.wait(lock, [this] {return stopping || !tasks.empty();});
+      if(tasks.empty()) return;
+      Request* request = tasks.front();
+      tasks.pop_front();
+      lock.unlock();
+      ssize_t result = request->operation == Operation::read
+                       ? pread(request->fd, request->range.iov_base, request->range.iov_len, request->offset)
+                       : pwrite(request->fd, request->range.iov_base, request->range.iov_len, request->offset);
+      request->result = result < 0 ? -errno : result;
+      lock.lock();
+      completions.push_back(request);
+      completion_condition.notify_all();
+    }
+  }
+
+  void complete(Request* request) {
+    std::unique_ptr<Request> owner(request);
+    if(request->callback) request->callback(request->result);
+  }
+
+  void queue(Operation operation, int fd, BufferView range, off_t offset, Callback&& callback) {
+    Request* request = new Request{operation, fd, range.getIovec(), offset, std::move(callback)};
+#ifdef MEMORYCTRL_IO_URING
+    if(ring_fd >= 0) return queueRing(request);
+#endif
+    ++in_flight;
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(request);
+    task_condition.notify_one();
+  }
+
+public:
+
+  AsyncIO(unsigned queue_depth = 64, unsigned thread_count = 2, bool use_uring = true) {
+#ifdef MEMORYCTRL_IO_URING
+    if(use_uring && setupRing(queue_depth)) return;
+#else
+    (void)queue_depth;
+    (void)use_uring;
+#endif
+    if(!thread_count) thread_count = 1;
+    for(unsigned index = 0; index < thread_count; ++index) threads.emplace_back(&AsyncIO::work, this);
+  }
+
+  AsyncIO(const AsyncIO&) = delete;
+  AsyncIO& operator=(const AsyncIO&) = delete;
+
+  // Completes every request in flight before closing, including ones queued by callbacks
+  ~AsyncIO() {
+    while(getInFlightCount()) wait(getInFlightCount());
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    task_condition.notify_all();
+    for(auto& thread : threads) thread.join();
+#ifdef MEMORYCTRL_IO_URING
+    closeRing();
+#endif
+  }
+
+  bool isUringEnabled() const noexcept {
+#ifdef MEMORYCTRL_IO_URING
+    return ring_fd >= 0;
+#else
+    return false;
+#endif
+  }
+
+  // Count of requests not completed yet, including ones waiting for room in the ring
+  size_t getInFlightCount() const noexcept {
+#ifdef MEMORYCTRL_IO_URING
+    return in_flight + deferred.size();
+#else
+    return in_flight;
+#endif
+  }
+
+  void read(int fd, BufferView range, off_t offset, Callback callback) {
+    queue(Operation::read, fd, range, offset, std::move(callback));
+  }
+
+  void write(int fd, BufferView range, off_t offset, Callback callback) {
+    queue(Operation::write, fd, range, offset, std::move(callback));
+  }
+
+  // Reads into size bytes reserved with addSizeToBack, a short read leaves the rest of them in place
+  template<typename Buffer>
+  void read(int fd, Buffer& buffer, size_t size, off_t offset, Callback callback) {
+    read(fd, BufferView(buffer.addSizeToBack(size), size), offset, std::move(callback));
+  }
+
+  std::future<ssize_t> read(int fd, BufferView range, off_t offset) {
+    auto promise = std::make_shared<std::promise<ssize_t>>();
+    std::future<ssize_t> future = promise->get_future();
+    read(fd, range, offset, [promise](ssize_t result) {promise->set_value(result);});
+    return future;
+  }
+
+  std::future<ssize_t> write(int fd, BufferView range, off_t offset) {
+    auto promise = std::make_shared<std::promise<ssize_t>>();
+    std::future<ssize_t> future = promise->get_future();
+    write(fd, range, offset, [promise](ssize_t result) {promise->set_value(result);});
+    return future;
+  }
+
+  // Hands queued requests to the kernel, requests to the thread pool start immediately
+  void submit(Error* err = nullptr) noexcept {
+#ifdef MEMORYCTRL_IO_URING
+    if(ring_fd < 0) return;
+    placeDeferred();
+    if(!submitRing() && err) *err = ErrorType::system_error;
+#else
+    (void)err;
+#endif
+  }
+
+  // Completes finished requests without blocking, returns count of them
+  size_t poll() {
+#ifdef MEMORYCTRL_IO_URING
+    if(ring_fd >= 0) return reapRing();
+#endif
+    std::vector<Request*> finished;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished.swap(completions);
+    }
+    in_flight -= finished.size();
+    for(Request* request : finished) complete(request);
+    return finished.size();
+  }
+
+  // Submits queued requests and blocks until at least min_count of them are completed
+  // Callbacks waiting themselves may complete requests the caller waits for,
+  // so it returns early once nothing is in flight
+  size_t wait(size_t min_count = 1, Error* err = nullptr) {
+    if(min_count > getInFlightCount()) min_count = getInFlightCount();
+    size_t count = 0;
+#ifdef MEMORYCTRL_IO_URING
+    if(ring_fd >= 0) {
+      submit(err);
+      count = reapRing();
+      while(count < min_count) {
+        placeDeferred();
+        if(!in_flight) break;
+        int result = enterRing(unsubmitted, 1, IORING_ENTER_GETEVENTS);
+        if(result < 0) {
+          if(err) *err = ErrorType::system_error;
+          break;
+        }
+        unsubmitted -= result;
+        count += reapRing();
+      }
+      return count;
+    }
+#else
+    (void)err;
+#endif
+    while(count < min_count && in_flight) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        completion_condition.wait(lock, [&] {return !completions.empty();});
+      }
+      count += poll();
+    }
+    return count;
+  }
+};
+
+#endif // MEMORYCTRL_POSIX
+
+// Buffer with free space kept in front of the payload: front operations move
+// the head offset instead of the payload, and the free space is reclaimed by
+// a single compaction once it's at least as large as the payload
+template<typename Buffer = BufferController>
+class BasicDequeController {
+  Buffer buffer;
+  size_t head = 0;
+
+  void reset() noexcept {
+    buffer.resize(0);
+    head = 0;
+  }
+
+public:
+
+  typedef uint8_t byte;
+  typedef uint8_t* iterator;
+  typedef const uint8_t* const_iterator;
+
+  BasicDequeController() noexcept = default;
+  BasicDequeController(size_t size) noexcept : buffer(size) {}
+  BasicDequeController(const void* buffer, size_t size) noexcept : buffer(buffer, size) {}
+  BasicDequeController(Buffer&& buffer) noexcept : buffer(std::move(buffer)) {}
+
+  bool isEmpty() const noexcept {return !getSize();}
+  void* getData() const noexcept {return begin();}
+
+  size_t getSize() const noexcept {return buffer.getSize() - head;}
+  size_t getCapacity() const noexcept {return buffer.getCapacity() - head;}
+  size_t getHeadOffset() const noexcept {return head;}
+  template<typename T>
+  size_t getCount() const noexcept {return getSize()/sizeof (T);}
+
+  void clear() noexcept {buffer.clear(); head = 0;}
+
+  // Moves the payload to the start of the storage
+  void compact() noexcept {
+    if(!head) return;
+    size_t size = getSize();
+    memmove(buffer.begin(), begin(), size);
+    buffer.resize(size);
+    head = 0;
+  }
+
+  void reserve(size_t new_capacity) noexcept {
+    if(getCapacity() >= new_capacity) return;
+    compact();
+    buffer.reserve(new_capacity);
+  }
+
+  void shrinkToFit() noexcept {
+    compact();
+    buffer.shrinkToFit();
+  }
+
+  void resize(size_t new_size) noexcept {
+    if(!new_size) return reset();
+    if(new_size > getCapacity() && head >= getSize()) compact();
+    buffer.resize(head + new_size);
+  }
+
+  void subSizeBack(size_t sub) noexcept {
+    if(sub >= getSize()) return reset();
+    buffer.subSizeBack(sub);
+  }
+
+  void subSizeFront(size_t sub) noexcept {
+    if(sub >= getSize()) return reset();
+    head += sub;
+  }
+
+  iterator addSizeToBack(size_t add) noexcept {
+    size_t old_size = getSize();
+    resize(old_size + add);
+    return begin() + old_size;
+  }
+
+  // Reserves front space as large as the payload, so repeated calls are amortized O(1)
+  iterator addSizeToFront(size_t add) noexcept {
+    if(head >= add) {
+      head -= add;
+      return begin();
+    }
+    size_t size = getSize();
+    size_t new_head = add + size;
+    buffer.resize(new_head + size);
+    memmove(buffer.begin() + new_head, buffer.begin() + head, size);
+    head = new_head - add;
+    return begin();
+  }
+
+  iterator pushBack(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    // Source may point into this buffer and move on compaction or reallocation
+    if(data >= buffer.begin() && data < buffer.end()) {
+      size_t offset = static_cast<const uint8_t*>(data) - begin();
+      auto data_it = addSizeToBack(size);
+      memmove(data_it, begin() + offset, size);
+      return data_it;
+    }
+    auto data_it = addSizeToBack(size);
+    memmove(data_it, data, size);
+    return data_it;
+  }
+
+  iterator pushFront(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return end();
+    }
+    if(data >= buffer.begin() && data < buffer.end()) {
+      size_t offset = static_cast<const uint8_t*>(data) - begin();
+      auto data_it = addSizeToFront(size);
+      memmove(data_it, begin() + size + offset, size);
+      return data_it;
+    }
+    auto data_it = addSizeToFront(size);
+    memmove(data_it, data, size);
+    return data_it;
+  }
+
+  template<typename T>
+  T* pushBack(const T& value) noexcept {return reinterpret_cast<T*>(pushBack(&value, sizeof (T)));}
+
+  template<typename T>
+  T* pushFront(const T& value) noexcept {return reinterpret_cast<T*>(pushFront(&value, sizeof (T)));}
+
+  byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return *(end() - 1);
+    }
+    return begin()[at];
+  }
+
+  template<typename T>
+  T& get(size_t at, size_t shift, Error* err = nullptr) const noexcept {
+    return *reinterpret_cast<T*>(&get(at * sizeof (T) + shift, err));
+  }
+
+  Buffer takeBack(size_t size, Error* err) noexcept {
+    if(!getSize()) {
+      if(err) *err = ErrorType::null_ponter;
+      return Buffer();
+    }
+    if(size > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return Buffer();
+    }
+    Buffer new_data(end() - size, size);
+    subSizeBack(size);
+    return new_data;
+  }
+
+  Buffer takeFront(size_t size, Error* err) noexcept {
+    if(!getSize()) {
+      if(err) *err = ErrorType::null_ponter;
+      return Buffer();
+    }
+    if(size > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return Buffer();
+    }
+    Buffer new_data(begin(), size);
+    subSizeFront(size);
+    return new_data;
+  }
+
+  template<typename T>
+  bool takeFront(T& value, Error* err = nullptr) noexcept {
+    if(sizeof (T) > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    memcpy(&value, begin(), sizeof (T));
+    subSizeFront(sizeof (T));
+    return true;
+  }
+
+  BufferView view() const noexcept {return BufferView(begin(), getSize());}
+
+#ifdef MEMORYCTRL_POSIX
+  // Written bytes are consumed by moving the head
+  size_t writeTo(int fd, Error* err = nullptr) noexcept {
+    BufferView unwritten = view();
+    size_t written = unwritten.writeTo(fd, err);
+    subSizeFront(written);
+    return written;
+  }
+
+  size_t readFrom(int fd, size_t size, Error* err = nullptr) noexcept {
+    iterator it = addSizeToBack(size);
+    ssize_t result;
+    do result = read(fd, it, size);
+    while(result < 0 && errno == EINTR);
+    if(result < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK && err) *err = ErrorType::system_error;
+      result = 0;
+    }
+    subSizeBack(size - result);
+    return result;
+  }
+#endif
+
+  // Taken bytes stay in place before the head, the view is valid until the next growth
+  BufferView takeFrontView(size_t size, Error* err = nullptr) noexcept {
+    if(size > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    BufferView front(begin(), size);
+    head += size;
+    return front;
+  }
+
+  BufferView takeBackView(size_t size, Error* err = nullptr) noexcept {
+    if(size > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return BufferView();
+    }
+    // Shrinks without the allocator release hook, it could drop the pages under the view
+    return buffer.takeBackView(size);
+  }
+
+  iterator begin() const noexcept {return buffer.begin() + head;}
+  iterator end() const noexcept {return buffer.end();}
+
+  template<typename T>
+  T* begin() const noexcept {return reinterpret_cast<T*>(begin());}
+  template<typename T>
+  T* end() const noexcept {return reinterpret_cast<T*>(begin()) + getCount<T>();}
+
+  byte& operator[](size_t index) const noexcept {return get(index);}
+};
+
+typedef BasicDequeController<> DequeController;
+
+// Buffer keeping its free space as a gap at the last edit position,
+// so edits near the previous one only move the bytes between them
+template<typename Buffer = BufferController>
+class BasicGapController {
+  // Storage layout: [payload before gap][gap][payload after gap]
+  Buffer buffer;
+  size_t gap_begin = 0;
+  size_t gap_end = 0;
+
+  // Gap grows to at least the payload size, so insertions are amortized O(edit size)
+  void growGap(size_t add) noexcept {
+    size_t gap_size = getGapSize();
+    if(gap_size >= add) return;
+    size_t tail_size = buffer.getSize() - gap_end;
+    size_t new_gap_size = add + getSize();
+    buffer.resize(buffer.getSize() + new_gap_size - gap_size);
+    memmove(buffer.begin() + gap_begin + new_gap_size, buffer.begin() + gap_end, tail_size);
+    gap_end = gap_begin + new_gap_size;
+  }
+
+public:
+
+  typedef uint8_t byte;
+  typedef uint8_t* iterator;
+  typedef const uint8_t* const_iterator;
+
+  BasicGapController() noexcept = default;
+  BasicGapController(const void* buffer, size_t size) noexcept
+    : buffer(buffer, size), gap_begin(size), gap_end(size) {}
+  BasicGapController(Buffer&& buffer) noexcept
+    : buffer(std::move(buffer)), gap_begin(this->buffer.getSize()), gap_end(gap_begin) {}
+
+  bool isEmpty() const noexcept {return !getSize();}
+  size_t getSize() const noexcept {return buffer.getSize() - getGapSize();}
+  size_t getCapacity() const noexcept {return buffer.getCapacity() - getGapSize();}
+  size_t getGapOffset() const noexcept {return gap_begin;}
+  size_t getGapSize() const noexcept {return gap_end - gap_begin;}
+  bool isContiguous() const noexcept {return gap_end == buffer.getSize();}
+
+  void clear() noexcept {buffer.clear(); gap_begin = gap_end = 0;}
+
+  // Moves the gap to the byte with position at
+  void moveGap(size_t at, Error* err = nullptr) noexcept {
+    if(at > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    if(at < gap_begin) {
+      size_t count = gap_begin - at;
+      memmove(buffer.begin() + gap_end - count, buffer.begin() + at, count);
+      gap_begin -= count;
+      gap_end -= count;
+    } else if(at > gap_begin) {
+      size_t count = at - gap_begin;
+      memmove(buffer.begin() + gap_begin, buffer.begin() + gap_end, count);
+      gap_begin += count;
+      gap_end += count;
+    }
+  }
+
+  // Moves the gap behind the payload, begin()/end() are valid only after this
+  iterator compact() noexcept {
+    moveGap(getSize());
+    buffer.resize(gap_begin);
+    gap_end = gap_begin;
+    return begin();
+  }
+
+  iterator addSizeTo(size_t to, size_t add, Error* err = nullptr) noexcept {
+    if(to > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return nullptr;
+    }
+    moveGap(to);
+    growGap(add);
+    iterator it = buffer.begin() + gap_begin;
+    gap_begin += add;
+    return it;
+  }
+
+  iterator insert(size_t to, const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return nullptr;
+    }
+    iterator it = addSizeTo(to, size, err);
+    if(it) memcpy(it, data, size);
+    return it;
+  }
+
+  template<typename T>
+  T* insert(size_t index, size_t shift, const T& value, Error* err = nullptr) noexcept {
+    return reinterpret_cast<T*>(insert(index * sizeof (T) + shift, &value, sizeof (T), err));
+  }
+
+  iterator pushBack(const void* data, size_t size, Error* err = nullptr) noexcept {
+    return insert(getSize(), data, size, err);
+  }
+
+  iterator pushFront(const void* data, size_t size, Error* err = nullptr) noexcept {
+    return insert(0, data, size, err);
+  }
+
+  void remove(size_t at, size_t count = 1, Error* err = nullptr) noexcept {
+    if(at + count > getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return;
+    }
+    moveGap(at);
+    gap_end += count;
+  }
+
+  byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      at = getSize() - 1;
+    }
+    return buffer.begin()[at < gap_begin ? at : at + getGapSize()];
+  }
+
+  byte& operator[](size_t index) const noexcept {return get(index);}
+
+  iterator begin() const noexcept {return buffer.begin();}
+  iterator end() const noexcept {return buffer.begin() + gap_begin;}
+};
+
+typedef BasicGapController<> GapController;
+
+// Buffer made of a list of chunks: appending a chunk or another segmented
+// buffer links it without copying, reading walks across chunk boundaries.
+// Only the first chunk may be partly consumed, so linking a buffer whose front
+// was consumed behind other chunks first moves the rest of that chunk to its start
+template<typename Buffer = BufferController>
+class BasicSegmentedController {
+  std::list<Buffer> chunks;
+  size_t size = 0;
+  // Bytes consumed from the front of the first chunk
+  size_t head = 0;
+
+  // Makes the head offset physical before the first chunk stops being first
+  void dropHead() noexcept {
+    if(!head) return;
+    chunks.front().subSizeFront(head);
+    head = 0;
+  }
+
+public:
+
+  typedef uint8_t byte;
+  typedef std::list<Buffer> ChunkList;
+
+  class iterator {
+    typename ChunkList::const_iterator chunk, chunk_end;
+    size_t offset = 0;
+
+    void skipEmpty() noexcept {
+      while(chunk != chunk_end && offset >= chunk->getSize()) {
+        ++chunk;
+        offset = 0;
+      }
+    }
+
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef byte value_type;
+    typedef ptrdiff_t difference_type;
+    typedef byte* pointer;
+    typedef byte& reference;
+
+    iterator() noexcept = default;
+    iterator(typename ChunkList::const_iterator chunk, typename ChunkList::const_iterator chunk_end, size_t offset = 0) noexcept
+      : chunk(chunk), chunk_end(chunk_end), offset(offset) {skipEmpty();}
+
+    byte& operator*() const noexcept {return chunk->begin()[offset];}
+    iterator& operator++() noexcept {++offset; skipEmpty(); return *this;}
+    iterator operator++(int) noexcept {iterator tmp(*this); ++*this; return tmp;}
+    bool operator==(const iterator& other) const noexcept {return chunk == other.chunk && offset == other.offset;}
+    bool operator!=(const iterator& other) const noexcept {return !(*this == other);}
+  };
+
+  BasicSegmentedController() noexcept = default;
+  BasicSegmentedController(Buffer&& chunk) noexcept {append(std::move(chunk));}
+  BasicSegmentedController(std::initializer_list<Buffer> chunk_list) {
+    for(auto& chunk : chunk_list) pushBack(chunk.getData(), chunk.getSize());
+  }
+
+  bool isEmpty() const noexcept {return !size;}
+  size_t getSize() const noexcept {return size;}
+  size_t getChunkCount() const noexcept {return chunks.size();}
+  const ChunkList& getChunks() const noexcept {return chunks;}
+  size_t getHeadOffset() const noexcept {return head;}
+
+  void clear() noexcept {chunks.clear(); size = 0; head = 0;}
+
+  // Links chunk to the end without copying its bytes
+  void append(Buffer&& chunk) {
+    if(chunk.isEmpty()) return;
+    size += chunk.getSize();
+    chunks.push_back(std::move(chunk));
+  }
+
+  // Moves the rest of a partly consumed first chunk within that chunk
+  void prepend(Buffer&& chunk) {
+    if(chunk.isEmpty()) return;
+    dropHead();
+    size += chunk.getSize();
+    chunks.push_front(std::move(chunk));
+  }
+
+  // Moves all chunks of other to the end, O(1) unless the front of other was consumed,
+  // then the rest of its first chunk is moved within that chunk
+  void append(BasicSegmentedController&& other) noexcept {
+    other.dropHead();
+    if(chunks.empty()) head = 0;
+    size += other.size;
+    chunks.splice(chunks.end(), other.chunks);
+    other.size = 0;
+  }
+
+  void prepend(BasicSegmentedController&& other) noexcept {
+    if(other.isEmpty()) return;
+    dropHead();
+    head = other.head;
+    size += other.size;
+    chunks.splice(chunks.begin(), other.chunks);
+    other.size = 0;
+    other.head = 0;
+  }
+
+  // Releases consumed chunks and moves the head inside the first one, bytes aren't moved
+  void subSizeFront(size_t sub) noexcept {
+    if(sub >= size) return clear();
+    size -= sub;
+    sub += head;
+    while(sub >= chunks.front().getSize()) {
+      sub -= chunks.front().getSize();
+      chunks.pop_front();
+    }
+    head = sub;
+  }
+
+  void pushBack(const void* data, size_t size, Error* err = nullptr) {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return;
+    }
+    append(Buffer(data, size));
+  }
+
+  void pushFront(const void* data, size_t size, Error* err = nullptr) {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return;
+    }
+    prepend(Buffer(data, size));
+  }
+
+  byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= size) {
+      if(err) *err = ErrorType::out_of_range;
+      return chunks.back().last();
+    }
+    at += head;
+    for(auto& chunk : chunks) {
+      if(at < chunk.getSize()) return chunk.get(at);
+      at -= chunk.getSize();
+    }
+    return chunks.back().last();
+  }
+
+  // Copies all chunks into one contiguous buffer
+  Buffer flatten() const {
+    Buffer buffer;
+    buffer.reserve(size);
+    for(auto& chunk : chunks)
+      if(&chunk == &chunks.front()) buffer.pushBack(chunk.begin() + head, chunk.getSize() - head);
+      else buffer.pushBack(chunk.getData(), chunk.getSize());
+    return buffer;
+  }
+
+  // Replaces the chunks with a single contiguous one
+  Buffer& compact() {
+    if(chunks.size() > 1) {
+      Buffer buffer = flatten();
+      chunks.clear();
+      chunks.push_back(std::move(buffer));
+      head = 0;
+    } else if(chunks.empty()) chunks.emplace_back();
+    dropHead();
+    return chunks.front();
+  }
+
+#ifdef MEMORYCTRL_POSIX
+  // Fills up to max_count entries for readv/writev, returns count of filled entries
+  size_t getIovecs(iovec* iovecs, size_t max_count) const noexcept {
+    size_t count = 0;
+    for(auto it = chunks.begin(); it != chunks.end() && count < max_count; ++it) {
+      size_t offset = it == chunks.begin() ? head : 0;
+      iovecs[count++] = iovec{it->begin() + offset, it->getSize() - offset};
+    }
+    return count;
+  }
+
+  // Writes with writev until empty or fd would block, written bytes are consumed from the front
+  size_t writeTo(int fd, Error* err = nullptr) noexcept {
+    constexpr size_t batch_size = 64;
+    size_t total = 0;
+    while(size) {
+      iovec iovecs[batch_size];
+      ssize_t result = writev(fd, iovecs, getIovecs(iovecs, batch_size));
+      if(result < 0) {
+        if(errno == EINTR) continue;
+        if(errno != EAGAIN && errno != EWOULDBLOCK && err) *err = ErrorType::system_error;
+        break;
+      }
+      if(!result) break;
+      subSizeFront(result);
+      total += result;
+    }
+    return total;
+  }
+
+  // Reads up to size bytes with readv into the spare capacity of the last chunk and a new chunk
+  size_t readFrom(int fd, size_t size, Error* err = nullptr) {
+    Buffer* last = chunks.empty() ? nullptr : &chunks.back();
+    size_t spare = last ? last->getCapacity() - last->getSize() : 0;
+    if(spare > size) spare = size;
+    Buffer chunk(size - spare);
+    iovec iovecs[2];
+    int count = 0;
+    if(spare) iovecs[count++] = iovec{last->end(), spare};
+    if(size > spare) iovecs[count++] = iovec{chunk.begin(), size - spare};
+    ssize_t result;
+    do result = readv(fd, iovecs, count);
+    while(result < 0 && errno == EINTR);
+    if(result < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK && err) *err = ErrorType::system_error;
+      return 0;
+    }
+    size_t read_size = result;
+    size_t to_last = read_size < spare ? read_size : spare;
+    if(to_last) {
+      last->addSizeToBack(to_last);
+      this->size += to_last;
+    }
+    if(read_size > spare) {
+      chunk.resize(read_size - spare);
+      append(std::move(chunk));
+    }
+    return read_size;
+  }
+#endif
+
+  iterator begin() const noexcept {return iterator(chunks.begin(), chunks.end(), head);}
+  iterator end() const noexcept {return iterator(chunks.end(), chunks.end());}
+
+  byte& operator[](size_t index) const noexcept {return get(index);}
+
+  BasicSegmentedController& operator+=(Buffer&& chunk) {
+    append(std::move(chunk));
+    return *this;
+  }
+
+  BasicSegmentedController& operator+=(BasicSegmentedController&& other) noexcept {
+    append(std::move(other));
+    return *this;
+  }
+};
+
+typedef BasicSegmentedController<> SegmentedController;
+
+// Slice of a buffer shared through an atomic reference counter. Copies and
+// slices only bump the counter, writers get their own copy of the slice
+// while the buffer is shared
+template<typename Buffer = BufferController>
+class BasicSharedController {
+  struct Block {
+    std::atomic<size_t> references;
+    Buffer buffer;
+    Block(Buffer&& buffer) noexcept : references(1), buffer(std::move(buffer)) {}
+  };
+
+  Block* block = nullptr;
+  size_t offset = 0;
+  size_t size = 0;
+
+  BasicSharedController(Block* block, size_t offset, size_t size) noexcept
+    : block(block), offset(offset), size(size) {
+    if(block) block->references.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void release() noexcept {
+    if(block && block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) delete block;
+    block = nullptr;
+  }
+
+public:
+
+  typedef uint8_t byte;
+  typedef const uint8_t* const_iterator;
+
+  BasicSharedController() noexcept = default;
+  BasicSharedController(Buffer&& buffer)
+    : block(new Block(std::move(buffer))), size(block->buffer.getSize()) {}
+  BasicSharedController(const void* data, size_t size)
+    : BasicSharedController(Buffer(data, size)) {}
+
+  BasicSharedController(const BasicSharedController& other) noexcept
+    : BasicSharedController(other.block, other.offset, other.size) {}
+
+  BasicSharedController(BasicSharedController&& other) noexcept
+    : block(other.block), offset(other.offset), size(other.size) {
+    other.block = nullptr;
+    other.offset = 0;
+    other.size = 0;
+  }
+
+  ~BasicSharedController() {release();}
+
+  BasicSharedController& operator=(const BasicSharedController& other) noexcept {
+    if(block != other.block) {
+      release();
+      block = other.block;
+      if(block) block->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    offset = other.offset;
+    size = other.size;
+    return *this;
+  }
+
+  BasicSharedController& operator=(BasicSharedController&& other) noexcept {
+    if(this == &other) return *this;
+    release();
+    block = other.block;
+    offset = other.offset;
+    size = other.size;
+    other.block = nullptr;
+    other.offset = 0;
+    other.size = 0;
+    return *this;
+  }
+
+  bool isEmpty() const noexcept {return !size;}
+  bool isUnique() const noexcept {return !block || block->references.load(std::memory_order_acquire) == 1;}
+  size_t getUseCount() const noexcept {return block ? block->references.load(std::memory_order_relaxed) : 0;}
+  size_t getSize() const noexcept {return size;}
+
+  void clear() noexcept {
+    release();
+    offset = 0;
+    size = 0;
+  }
+
+  // Shares the bytes of the range instead of copying them
+  BasicSharedController slice(size_t at, size_t size, Error* err = nullptr) const noexcept {
+    if(at + size > this->size) {
+      if(err) *err = ErrorType::out_of_range;
+      return BasicSharedController();
+    }
+    return BasicSharedController(block, offset + at, size);
+  }
+
+  void subSizeFront(size_t sub) noexcept {
+    if(sub > size) sub = size;
+    offset += sub;
+    size -= sub;
+  }
+
+  void subSizeBack(size_t sub) noexcept {size -= sub > size ? size : sub;}
+
+  // Gives this controller its own copy of the slice if the buffer is shared
+  void detach() {
+    if(isUnique()) return;
+    BasicSharedController copy(Buffer(begin(), size));
+    *this = std::move(copy);
+  }
+
+  const_iterator begin() const noexcept {return block ? block->buffer.begin() + offset : nullptr;}
+  const_iterator end() const noexcept {return begin() + size;}
+
+  const byte& get(size_t at, Error* err = nullptr) const noexcept {
+    if(at >= size) {
+      if(err) *err = ErrorType::out_of_range;
+      return begin()[size - 1];
+    }
+    return begin()[at];
+  }
+
+  const byte& operator[](size_t index) const noexcept {return begin()[index];}
+
+  // Read-only by contract, use mutableView for writing
+  BufferView view() const noexcept {return BufferView(begin(), size);}
+
+  BufferView mutableView() {
+    detach();
+    return BufferView(begin(), size);
+  }
+
+  void pushBack(const void* data, size_t size, Error* err = nullptr) {
+    if(!data) {
+      if(err) *err = ErrorType::null_ponter;
+      return;
+    }
+    if(!block || !isUnique()) {
+      Buffer buffer;
+      buffer.reserve(this->size + size);
+      if(this->size) buffer.pushBack(begin(), this->size);
+      buffer.pushBack(data, size);
+      *this = BasicSharedController(std::move(buffer));
+      return;
+    }
+    block->buffer.resize(offset + this->size);
+    block->buffer.pushBack(data, size);
+    this->size += size;
+  }
+
+  bool operator==(const BasicSharedController& other) const noexcept {return view() == other.view();}
+  bool operator!=(const BasicSharedController& other) const noexcept {return !(*this == other);}
+};
+
+typedef BasicSharedController<> SharedController;
+
+// Lock-free queue for one producer and one consumer thread over a power of two
+// region, positions only grow and are masked into the region. Each side keeps
+// its position and a cached copy of the other side's position on its own cache
+// line, so the other side's line is only read when the cached copy runs out.
+// A ring is used either as a byte stream (push/pop) or for records, not both
+template<typename Buffer = BufferController>
+class BasicRingController {
+  static constexpr size_t cache_line_size = 64;
+  // Record layout: [uint32_t size][payload][padding to record_alignment]
+  static constexpr size_t record_alignment = 8;
+  static constexpr uint32_t wrap_marker = UINT32_MAX;
+
+  struct alignas(cache_line_size) ProducerSide {
+    std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+  };
+
+  struct alignas(cache_line_size) ConsumerSide {
+    std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+  };
+
+  ProducerSide producer;
+  ConsumerSide consumer;
+  Buffer buffer;
+  size_t mask;
+
+  static size_t getRecordSize(size_t size) noexcept {
+    return (sizeof (uint32_t) + size + record_alignment - 1) & ~(record_alignment - 1);
+  }
+
+  uint8_t* getBase() const noexcept {return static_cast<uint8_t*>(buffer.getData());}
+
+  size_t getFree(size_t tail, size_t required) noexcept {
+    size_t free = getCapacity() - (tail - producer.cached_head);
+    if(free >= required) return free;
+    producer.cached_head = consumer.head.load(std::memory_order_acquire);
+    return getCapacity() - (tail - producer.cached_head);
+  }
+
+  size_t getUsed(size_t head, size_t required) noexcept {
+    size_t used = consumer.cached_tail - head;
+    if(used >= required) return used;
+    consumer.cached_tail = producer.tail.load(std::memory_order_acquire);
+    return consumer.cached_tail - head;
+  }
+
+  void copyIn(size_t position, const void* data, size_t size) noexcept {
+    size_t index = position & mask;
+    size_t first = size < getCapacity() - index ? size : getCapacity() - index;
+    memcpy(getBase() + index, data, first);
+    memcpy(getBase(), static_cast<const uint8_t*>(data) + first, size - first);
+  }
+
+  void copyOut(size_t position, void* data, size_t size) const noexcept {
+    size_t index = position & mask;
+    size_t first = size < getCapacity() - index ? size : getCapacity() - index;
+    memcpy(data, getBase() + index, first);
+    memcpy(static_cast<uint8_t*>(data) + first, getBase(), size - first);
+  }
+
+  // Writes a record at tail, records never wrap, so a wrap marker fills the end of the region.
+  // Returns the new tail or tail if there is no room
+  size_t writeRecord(size_t tail, const void* data, size_t size) noexcept {
+    size_t record_size = getRecordSize(size);
+    size_t index = tail & mask;
+    size_t padding = index + record_size > getCapacity() ? getCapacity() - index : 0;
+    if(getFree(tail, padding + record_size) < padding + record_size) return tail;
+    if(padding) {
+      memcpy(getBase() + index, &wrap_marker, sizeof (uint32_t));
+      tail += padding;
+      index = 0;
+    }
+    uint32_t record_header = uint32_t(size);
+    memcpy(getBase() + index, &record_header, sizeof (uint32_t));
+    memcpy(getBase() + index + sizeof (uint32_t), data, size);
+    return tail + record_size;
+  }
+
+public:
+
+  typedef uint8_t byte;
+
+  // Capacity is rounded up to a power of two
+  BasicRingController(size_t capacity) noexcept
+    : mask(Pow2Growth::getNearestPow2(capacity < 2 * record_alignment ? 2 * record_alignment : capacity) - 1) {
+    buffer.resize(mask + 1);
+  }
+
+  BasicRingController(const BasicRingController&) = delete;
+  BasicRingController& operator=(const BasicRingController&) = delete;
+
+  size_t getCapacity() const noexcept {return mask + 1;}
+
+  // Records of up to half of the capacity always fit into an empty ring
+  size_t getMaxRecordSize() const noexcept {return getCapacity() / 2 - sizeof (uint32_t);}
+
+  // Approximate while the other side is running
+  size_t getSize() const noexcept {
+    return producer.tail.load(std::memory_order_acquire) - consumer.head.load(std::memory_order_acquire);
+  }
+
+  bool isEmpty() const noexcept {return !getSize();}
+
+  // Producer side
+
+  // Pushes all bytes or nothing
+  bool pushBytes(const void* data, size_t size) noexcept {
+    size_t tail = producer.tail.load(std::memory_order_relaxed);
+    if(getFree(tail, size) < size) return false;
+    copyIn(tail, data, size);
+    producer.tail.store(tail + size, std::memory_order_release);
+    return true;
+  }
+
+  // Pushes as many whole values as fit, returns their count
+  template<typename T>
+  size_t push(const T* values, size_t count) noexcept {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    size_t tail = producer.tail.load(std::memory_order_relaxed);
+    size_t free_count = getFree(tail, count * sizeof (T)) / sizeof (T);
+    if(count > free_count) count = free_count;
+    if(!count) return 0;
+    copyIn(tail, values, count * sizeof (T));
+    producer.tail.store(tail + count * sizeof (T), std::memory_order_release);
+    return count;
+  }
+
+  template<typename T>
+  bool push(const T& value) noexcept {return push(&value, 1);}
+
+  bool pushRecord(const void* data, size_t size, Error* err = nullptr) noexcept {
+    if(size > getMaxRecordSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    size_t tail = producer.tail.load(std::memory_order_relaxed);
+    size_t new_tail = writeRecord(tail, data, size);
+    if(new_tail == tail) return false;
+    producer.tail.store(new_tail, std::memory_order_release);
+    return true;
+  }
+
+  bool pushRecord(const BufferView& record, Error* err = nullptr) noexcept {
+    return pushRecord(record.getData(), record.getSize(), err);
+  }
+
+  // Publishes the records that fit with a single store, returns their count
+  size_t pushRecords(const BufferView* records, size_t count, Error* err = nullptr) noexcept {
+    size_t tail = producer.tail.load(std::memory_order_relaxed);
+    size_t pushed = 0;
+    for(; pushed < count; ++pushed) {
+      if(records[pushed].getSize() > getMaxRecordSize()) {
+        if(err) *err = ErrorType::out_of_range;
+        break;
+      }
+      size_t new_tail = writeRecord(tail, records[pushed].getData(), records[pushed].getSize());
+      if(new_tail == tail) break;
+      tail = new_tail;
+    }
+    if(pushed) producer.tail.store(tail, std::memory_order_release);
+    return pushed;
+  }
+
+  // Consumer side
+
+  // Pops up to size bytes, returns their count
+  size_t popBytes(void* data, size_t size) noexcept {
+    size_t head = consumer.head.load(std::memory_order_relaxed);
+    size_t used = getUsed(head, size);
+    if(size > used) size = used;
+    if(!size) return 0;
+    copyOut(head, data, size);
+    consumer.head.store(head + size, std::memory_order_release);
+    return size;
+  }
+
+  // Pops as many whole values as available, returns their count
+  template<typename T>
+  size_t pop(T* values, size_t count) noexcept {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    size_t head = consumer.head.load(std::memory_order_relaxed);
+    size_t used_count = getUsed(head, count * sizeof (T)) / sizeof (T);
+    if(count > used_count) count = used_count;
+    if(!count) return 0;
+    copyOut(head, values, count * sizeof (T));
+    consumer.head.store(head + count * sizeof (T), std::memory_order_release);
+    return count;
+  }
+
+  template<typename T>
+  bool pop(T& value) noexcept {return pop(&value, 1);}
+
+  // Calls callback(BufferView) for up to max_count available records and releases
+  // their space with a single store after the last call, views are valid only inside the callback
+  template<typename F>
+  size_t popRecords(F&& callback, size_t max_count = SIZE_MAX) noexcept {
+    size_t head = consumer.head.load(std::memory_order_relaxed);
+    size_t tail = head + getUsed(head, SIZE_MAX);
+    size_t popped = 0;
+    while(head != tail && popped < max_count) {
+      size_t index = head & mask;
+      uint32_t record_header;
+      memcpy(&record_header, getBase() + index, sizeof (uint32_t));
+      if(record_header == wrap_marker) {
+        head += getCapacity() - index;
+        continue;
+      }
+      callback(BufferView(getBase() + index + sizeof (uint32_t), record_header));
+      head += getRecordSize(record_header);
+      ++popped;
+    }
+    consumer.head.store(head, std::memory_order_release);
+    return popped;
+  }
+
+  // Copies the next record to the back of output
+  template<typename Output>
+  bool popRecord(Output& output) noexcept {
+    return popRecords([&output](const BufferView& record) {
+      output.pushBack(record.getData(), record.getSize());
+    }, 1);
+  }
+};
+
+typedef BasicRingController<> RingController;
+
+
+template<typename T, typename Buffer = BufferController>
+class TypedInterface {
+  Buffer& buffer;
+public:
+
+  typedef T Type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
-  iterator insert(size_t to, BufferController&& other, Error* err = nullptr) noexcept {
-    return insert(to, other.data, other.size, err);
-  }
+  TypedInterface(Buffer& buffer) noexcept : buffer(buffer) {}
 
-  iterator pushFront(const BufferController& other, Error* err = nullptr) noexcept {
-    return pushFront(other.data, other.size, err);
-  }
+  void resize(size_t count) {return buffer.template resize<T>(count);}
+  void reserve(size_t count) {return buffer.template reserve<T>(count);}
 
-  iterator pushFront(BufferController&& other, Error* err = nullptr) noexcept {
-    return pushFront(other.data, other.size, err);
-  }
+  size_t getCount() const noexcept {return buffer.template getCount<T>();}
 
-  template<typename T, typename... Args>
+  template<typename... Args>
   T* emplaceBack(Args&&... args) noexcept {
-    return reinterpret_cast<T*>(new (addSizeToBack(sizeof (T))) T(std::forward<Args>(args)...));
+    return buffer.template emplaceBack<T>(std::forward<Args>(args)...);
   }
 
-  template<typename T, typename... Args>
+  template<typename... Args>
   T* emplaceAt(size_t index, size_t shift, Args&&... args, Error* err = nullptr) noexcept {
-    if((index * sizeof (T) + shift) > size) {
-      if(err) *err = ErrorType::out_of_range;
-      return end<T>();
-    }
-    return reinterpret_cast<T*>(new (addSizeTo(index * sizeof (T) + shift, sizeof (T))) T(std::forward<Args>(args)...));
+    return buffer.template emplaceAt<T>(index, shift, std::forward<Args>(args)..., err);
   }
 
-  template<typename T, typename... Args>
+  template<typename... Args>
   T* emplaceFront(Args&&... args) noexcept {
-    return reinterpret_cast<T*>(new (addSizeToFront(sizeof (T))) T(std::forward<Args>(args)...));
+    return buffer.template emplaceFront<T>(std::forward<Args>(args)...);
   }
 
-  template<typename T>
   void destruct(size_t at, size_t shift, size_t count = 1, Error* err = nullptr) noexcept {
-    if((at * sizeof (T) + shift + count * sizeof (T)) >= size) {
-      if(err) *err = ErrorType::out_of_range;
-      return;
-    }
-    for(T* it = reinterpret_cast<T*>(data + shift) + at,
-        * end = reinterpret_cast<T*>(data + shift) + at + count;
-        it != end; ++it)
-      it->~T();
+    return buffer.template destruct<T>(at, shift, count, err);
   }
 
-  template<typename T>
-  void destructFirst() noexcept {
-    return destruct<T>(0, 0, 1, nullptr);
-  }
+  T* pushBack(const T& value) noexcept {return buffer.template pushBack<T>(value);}
 
-  template<typename T>
-  void destructLast() noexcept {
-    return destruct<T>(getCount<T>() - 1, 0, 1, nullptr);
+  T* pushBack(T&& value) noexcept {return buffer.template emplaceBack<T>(std::move(value));}
+
+  T* insert(size_t index, size_t shift, const T& value, Error* err = nullptr) noexcept {
+    return buffer.template insert<T>(index, shift, value, err);
   }
 
-  template<typename T>
-  void destructAll() noexcept {
-    return destruct<T>(0, 0, getCount<T>(), nullptr);
+  T* insert(size_t index, size_t shift, T&& value, Error* err = nullptr) noexcept {
+    return buffer.template emplaceAt<T>(index, shift, std::move(value), err);
   }
 
-  template<typename T>
-  T* pushBack(const T& value) noexcept {return reinterpret_cast<T*>(pushBack(&value, sizeof (T)));}
+  T* pushFront(const T& value) noexcept {return buffer.template pushFront<T>(value);}
 
-  template<typename T>
-  T* pushBack(T&& value) noexcept {return emplaceBack<T>(std::move(value));}
+  T* pushFront(T&& value) noexcept {return buffer.template emplaceFront<T>(std::move(value));}
 
-  template<typename T>
-  T* insert(size_t index, size_t shift, const T& value, Error* err = nullptr) noexcept {
-    return reinterpret_cast<T*>(insert(index * sizeof (T) + shift, &value, sizeof (T), err));
-  }
+  iterator begin() const noexcept {return buffer.template begin<T>();}
+  iterator end() const noexcept {return buffer.template end<T>();}
 
-  template<typename T>
-  T* insert(size_t index, size_t shift, T&& value, Error* err = nullptr) noexcept {
-    return emplaceAt<T>(index, shift, std::move(value), err);
-  }
+  const_iterator cbegin() const noexcept {return buffer.template cbegin<T>();}
+  const_iterator cend() const noexcept {return buffer.template cend<T>();}
 
-  template<typename T>
-  T* pushFront(const T& value) noexcept {return reinterpret_cast<T*>(pushFront(&value, sizeof (T)));}
+  reverse_iterator rbegin() const noexcept {return buffer.template rbegin<T>();}
+  reverse_iterator rend() const noexcept {return buffer.template rend<T>();}
 
-  template<typename T>
-  T* pushFront(T&& value) noexcept {return emplaceFront<T>(std::move(value));}
+  const_reverse_iterator crbegin() const noexcept {return buffer.template crbegin<T>();}
+  const_reverse_iterator crend() const noexcept {return buffer.template crend<T>();}
+};
 
-  void remove(size_t at, size_t count = 1, Error* err = nullptr) noexcept {
-    if(!at && count == size) return resize(0);
-    if(at + count > size) {
-      if(err) *err = ErrorType::out_of_range;
-      return;
+// Bounded lock-free queue for many producers and many consumers over a power of
+// two array of cells. Each cell has a sequence number telling which position may
+// use it next: a producer of position p waits for p, a consumer waits for p + 1
+// and hands the cell to the producer of the next lap with p + capacity
+template<typename T, typename Buffer = BufferController>
+class BasicBoundedQueue {
+  static constexpr size_t cache_line_size = 64;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    alignas(T) uint8_t storage[sizeof (T)];
+
+    Cell(size_t sequence) noexcept : sequence(sequence) {}
+    T* get() noexcept {return std::launder(reinterpret_cast<T*>(storage));}
+  };
+
+  static_assert(alignof(Cell) <= alignof(std::max_align_t), "Over-aligned T is not supported");
+
+  struct alignas(cache_line_size) Position {
+    std::atomic<size_t> value{0};
+  };
+
+  Position enqueue_position;
+  Position dequeue_position;
+  Buffer buffer;
+  Cell* cells;
+  size_t mask;
+
+  template<typename F>
+  bool tryPushWith(F&& construct) noexcept {
+    size_t position = enqueue_position.value.load(std::memory_order_relaxed);
+    for(;;) {
+      Cell& cell = cells[position & mask];
+      ptrdiff_t difference = ptrdiff_t(cell.sequence.load(std::memory_order_acquire) - position);
+      if(difference < 0) return false;
+      if(difference > 0) position = enqueue_position.value.load(std::memory_order_relaxed);
+      else if(enqueue_position.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        construct(cell.storage);
+        cell.sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
     }
-    memmove(data + at, data + at + size, size - count - at);
-    subSizeBack(at);
   }
 
-  template<typename T>
-  void remove(size_t at, size_t shift, size_t count = 1, Error* err = nullptr) noexcept {
-    return remove(at * sizeof(T) + shift, count, err);
-  }
+  static void spin() noexcept {std::this_thread::yield();}
 
-  byte& get(size_t at, Error* err = nullptr) const noexcept {
-    if(at >= size) {
-      if(err) *err = ErrorType::out_of_range;
-      return data[size - 1];
-    }
-    return data[at];
+public:
+
+  typedef T Type;
+
+  // Capacity is rounded up to a power of two
+  BasicBoundedQueue(size_t capacity) noexcept
+    : mask(Pow2Growth::getNearestPow2(capacity < 2 ? 2 : capacity) - 1) {
+    TypedInterface<Cell, Buffer> cell_interface(buffer);
+    cell_interface.reserve(mask + 1);
+    for(size_t index = 0; index <= mask; ++index) cell_interface.emplaceBack(index);
+    cells = cell_interface.begin();
   }
 
-  template<typename T>
-  T& get(size_t at, size_t shift, Error* err = nullptr) const noexcept {
-    return *reinterpret_cast<T*>(&get(at * sizeof (T) + shift, err));
+  BasicBoundedQueue(const BasicBoundedQueue&) = delete;
+  BasicBoundedQueue& operator=(const BasicBoundedQueue&) = delete;
+
+  ~BasicBoundedQueue() {
+    size_t end = enqueue_position.value.load(std::memory_order_relaxed);
+    for(size_t position = dequeue_position.value.load(std::memory_order_relaxed); position != end; ++position)
+      cells[position & mask].get()->~T();
   }
 
-  byte& first(Error* err = nullptr) const noexcept {
-    if(!size) {
-      if(err) *err = ErrorType::null_ponter;
-      return get(0);
-    }
-    return get(0);
+  size_t getCapacity() const noexcept {return mask + 1;}
+
+  // Approximate while other threads are running
+  size_t getSize() const noexcept {
+    size_t dequeued = dequeue_position.value.load(std::memory_order_relaxed);
+    size_t enqueued = enqueue_position.value.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
   }
 
-  template<typename T>
-  T& first(Error* err = nullptr) const noexcept {
-    if(!size) {
-      if(err) *err = ErrorType::null_ponter;
-      return get<T>(0,0);
-    }
-    return get<T>(0,0);
+  template<typename... Args>
+  bool tryEmplace(Args&&... args) noexcept {
+    return tryPushWith([&](uint8_t* storage) {new (storage) T(std::forward<Args>(args)...);});
   }
 
-  byte& last(Error* err = nullptr) const noexcept {
-    if(!size) {
-      if(err) *err = ErrorType::null_ponter;
-      return get(0);
+  bool tryPush(const T& value) noexcept {return tryEmplace(value);}
+  bool tryPush(T&& value) noexcept {return tryEmplace(std::move(value));}
+
+  bool tryPop(T& value) noexcept {
+    size_t position = dequeue_position.value.load(std::memory_order_relaxed);
+    for(;;) {
+      Cell& cell = cells[position & mask];
+      ptrdiff_t difference = ptrdiff_t(cell.sequence.load(std::memory_order_acquire) - (position + 1));
+      if(difference < 0) return false;
+      if(difference > 0) position = dequeue_position.value.load(std::memory_order_relaxed);
+      else if(dequeue_position.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        value = std::move(*cell.get());
+        cell.get()->~T();
+        cell.sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+      }
     }
-    return get(size - 1);
   }
 
-  template<typename T>
-  T& last(Error* err = nullptr) const noexcept {
-    if(!size) {
-      if(err) *err = ErrorType::null_ponter;
-      return get<T>(0,0);
+  // Claims a run of free cells with a single CAS, returns the count of pushed values
+  size_t tryPushBulk(const T* values, size_t count) noexcept {
+    size_t position = enqueue_position.value.load(std::memory_order_relaxed);
+    for(;;) {
+      if(!count) return 0;
+      ptrdiff_t difference = ptrdiff_t(cells[position & mask].sequence.load(std::memory_order_acquire) - position);
+      if(difference < 0) return 0;
+      if(difference > 0) {
+        position = enqueue_position.value.load(std::memory_order_relaxed);
+        continue;
+      }
+      size_t available = 1;
+      while(available < count &&
+            cells[(position + available) & mask].sequence.load(std::memory_order_acquire) == position + available)
+        ++available;
+      if(!enqueue_position.value.compare_exchange_weak(position, position + available, std::memory_order_relaxed))
+        continue;
+      for(size_t index = 0; index < available; ++index) {
+        Cell& cell = cells[(position + index) & mask];
+        new (cell.storage) T(values[index]);
+        cell.sequence.store(position + index + 1, std::memory_order_release);
+      }
+      return available;
     }
-    return get<T>(getCount<T>() - 1, 0);
   }
 
-  BufferController takeBack(size_t size, Error* err) noexcept {
-    if(!this->size) {
-      if(err) *err = ErrorType::null_ponter;
-      return BufferController();
-    }
-    if(size > this->size) {
-      if(err) *err = ErrorType::out_of_range;
-      return BufferController();
+  // Claims a run of filled cells with a single CAS, returns the count of popped values
+  size_t tryPopBulk(T* values, size_t count) noexcept {
+    size_t position = dequeue_position.value.load(std::memory_order_relaxed);
+    for(;;) {
+      if(!count) return 0;
+      ptrdiff_t difference = ptrdiff_t(cells[position & mask].sequence.load(std::memory_order_acquire) - (position + 1));
+      if(difference < 0) return 0;
+      if(difference > 0) {
+        position = dequeue_position.value.load(std::memory_order_relaxed);
+        continue;
+      }
+      size_t available = 1;
+      while(available < count &&
+            cells[(position + available) & mask].sequence.load(std::memory_order_acquire) == position + available + 1)
+        ++available;
+      if(!dequeue_position.value.compare_exchange_weak(position, position + available, std::memory_order_relaxed))
+        continue;
+      for(size_t index = 0; index < available; ++index) {
+        Cell& cell = cells[(position + index) & mask];
+        values[index] = std::move(*cell.get());
+        cell.get()->~T();
+        cell.sequence.store(position + index + mask + 1, std::memory_order_release);
+      }
+      return available;
     }
-    BufferController new_data(size);
-    memcpy(new_data.data, end() - size, size);
-    subSizeBack(size);
-    return new_data;
   }
 
-  BufferController takeFront(size_t size, Error* err) noexcept {
-    if(!this->size) {
-      if(err) *err = ErrorType::null_ponter;
-      return BufferController();
-    }
-    if(size > this->size) {
-      if(err) *err = ErrorType::out_of_range;
-      return BufferController();
-    }
-    BufferController new_data(size);
-    memcpy(new_data.data, data, size);
-    subSizeFront(size);
-    return new_data;
+  // Blocking variants yield while the queue is full or empty
+
+  void push(const T& value) noexcept {while(!tryPush(value)) spin();}
+  void push(T&& value) noexcept {while(!tryPush(std::move(value))) spin();}
+
+  T pop() noexcept {
+    T value;
+    while(!tryPop(value)) spin();
+    return value;
   }
 
-  BufferController takeFrom(size_t at, size_t size, Error* err) noexcept {
-    if(!this->size) {
-      if(err) *err = ErrorType::null_ponter;
-      return BufferController();
-    }
-    if(at + size > this->size) {
-      if(err) *err = ErrorType::out_of_range;
-      return BufferController();
+  void pushBulk(const T* values, size_t count) noexcept {
+    for(size_t pushed = 0; pushed < count;) {
+      size_t result = tryPushBulk(values + pushed, count - pushed);
+      if(!result) spin();
+      pushed += result;
     }
-    BufferController new_data(size);
-    memcpy(new_data.data, data + at, size);
-    subSizeFrom(at, size);
-    return new_data;
   }
 
-  iterator begin() const noexcept {return data;}
-  iterator end() const noexcept {return data + size;}
-
-  iterator cbegin() const noexcept {return data;}
-  iterator cend() const noexcept {return data + size;}
+  // Waits for at least one value, returns the count of popped values
+  size_t popBulk(T* values, size_t count) noexcept {
+    if(!count) return 0;
+    size_t result;
+    while(!(result = tryPopBulk(values, count))) spin();
+    return result;
+  }
+};
 
-  reverse_iterator rbegin() const noexcept {return reverse_iterator(data + size - 1);}
-  reverse_iterator rend() const noexcept {return reverse_iterator(data - 1);}
+template<typename T>
+using BoundedQueue = BasicBoundedQueue<T>;
 
-  const_reverse_iterator crbegin() const noexcept {return const_reverse_iterator(data + size - 1);}
-  const_reverse_iterator crend() const noexcept {return const_reverse_iterator(data - 1);}
+// Buffer many threads append to in parallel. reserveAppend claims a disjoint
+// range with a fetch_add, the range is written without locks and published with
+// commit. Writers hold a gate from reserve to commit, the thread whose claim
+// crosses the capacity seals the gate, waits for the writers to leave, grows the
+// buffer and reopens the gate. Commits are published in claim order, so readers
+// only see the prefix of fully written ranges.
+// A thread may hold at most one uncommitted range, and must not call reserveAppend
+// or read again before committing it: growth waits for every held range and moves the
+// buffer, so a second call hangs. To batch records, reserve their total size at once
+template<typename Buffer = BufferController>
+class BasicAppendController {
+  static constexpr size_t cache_line_size = 64;
+  static constexpr size_t sealed_bit = size_t(1) << (sizeof (size_t) * 8 - 1);
 
-  template<typename T>
-  T* begin() const noexcept {return reinterpret_cast<T*>(data);}
-  template<typename T>
-  T* end() const noexcept {return reinterpret_cast<T*>(data) + getCount<T>();}
+  struct alignas(cache_line_size) Counter {
+    std::atomic<size_t> value{0};
+  };
 
-  template<typename T>
-  const T* cbegin() const noexcept {return reinterpret_cast<T*>(data);}
-  template<typename T>
-  const T* cend() const noexcept {return reinterpret_cast<T*>(data) + getCount<T>();}
+  // Count of threads inside the gate and the sealed bit
+  Counter gate;
+  Counter reserved;
+  Counter committed;
+  Buffer buffer;
+  size_t capacity = 0;
 
-  template<typename T>
-  std::reverse_iterator<T*> rbegin() const noexcept {
-    return std::reverse_iterator<T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) + getCount<T>() - 1));
-  }
-  template<typename T>
-  std::reverse_iterator<T*> rend() const noexcept {
-    return std::reverse_iterator<T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) - 1));
-  }
+  static void spin() noexcept {std::this_thread::yield();}
 
-  template<typename T>
-  std::reverse_iterator<const T*> crbegin() const noexcept {
-    return std::reverse_iterator<const T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) + getCount<T>() - 1));
-  }
-  template<typename T>
-  std::reverse_iterator<const T*> crend() const noexcept {
-    return std::reverse_iterator<const T*>(reinterpret_cast<T*>(reinterpret_cast<T*>(data) - 1));
+  void enter() noexcept {
+    while(gate.value.fetch_add(1, std::memory_order_acquire) & sealed_bit) {
+      gate.value.fetch_sub(1, std::memory_order_relaxed);
+      while(gate.value.load(std::memory_order_relaxed) & sealed_bit) spin();
+    }
   }
 
-  byte& operator[](size_t index) const noexcept {return get(index);}
+  void leave() noexcept {gate.value.fetch_sub(1, std::memory_order_release);}
 
-  BufferController& operator+=(const BufferController& other) noexcept {
-    pushBack(other);
-    return *this;
+  // Called by the thread inside the gate whose claim crossed the capacity
+  void grow(size_t offset, size_t size) noexcept {
+    gate.value.fetch_or(sealed_bit, std::memory_order_relaxed);
+    leave();
+    while(gate.value.load(std::memory_order_acquire) != sealed_bit) spin();
+    // Every range before offset is committed, later claims failed and are dropped
+    buffer.resize(offset);
+    buffer.reserve(offset + size);
+    buffer.resize(buffer.getCapacity());
+    capacity = buffer.getSize();
+    reserved.value.store(offset + size, std::memory_order_relaxed);
+    gate.value.fetch_add(1, std::memory_order_relaxed);
+    gate.value.fetch_and(~sealed_bit, std::memory_order_release);
   }
 
-  BufferController operator+=(BufferController&& other) noexcept {
-    pushBack(std::move(other));
-    return *this;
-  }
+public:
 
-  BufferController operator+(const BufferController& other) noexcept {
-    BufferController tmp(*this);
-    tmp.pushBack(other);
-    return tmp;
-  }
+  typedef uint8_t byte;
 
-  BufferController operator+(BufferController&& other) noexcept {
-    BufferController tmp(*this);
-    tmp.pushBack(std::move(other));
-    return tmp;
+  BasicAppendController(size_t capacity = 0) noexcept {
+    buffer.reserve(capacity);
+    buffer.resize(buffer.getCapacity());
+    this->capacity = buffer.getSize();
   }
 
-  BufferController& operator=(const BufferController& other) noexcept {
-    resize(0);
-    pushBack(other);
-    return *this;
-  }
+  BasicAppendController(const BasicAppendController&) = delete;
+  BasicAppendController& operator=(const BasicAppendController&) = delete;
 
-  BufferController operator=(BufferController&& other) noexcept {
-    resize(0);
-    pushBack(std::move(other));
-    return *this;
+  // Returns the claimed range, it must be passed to commit by the same thread
+  // before it calls reserveAppend or read again
+  BufferView reserveAppend(size_t size) noexcept {
+    for(;;) {
+      enter();
+      size_t offset = reserved.value.fetch_add(size, std::memory_order_relaxed);
+      if(offset + size <= capacity)
+        return BufferView(static_cast<uint8_t*>(buffer.getData()) + offset, size);
+      if(offset <= capacity) {
+        grow(offset, size);
+        return BufferView(static_cast<uint8_t*>(buffer.getData()) + offset, size);
+      }
+      leave();
+      spin();
+    }
   }
 
-  bool operator==(const BufferController& other) noexcept {
-    if(size != other.size) return false;
-    for(iterator f_it = begin(),
-                 s_it = other.begin(),
-                 f_end = end();
-        f_it != f_end; (++f_it, ++s_it))
-      if(*f_it != *s_it) return false;
-    return true;
+  // Waits until the ranges claimed before are committed
+  void commit(const BufferView& range) noexcept {
+    size_t offset = static_cast<uint8_t*>(range.getData()) - static_cast<uint8_t*>(buffer.getData());
+    while(committed.value.load(std::memory_order_acquire) != offset) spin();
+    committed.value.store(offset + range.getSize(), std::memory_order_release);
+    leave();
   }
 
-  bool operator==(BufferController&& other) noexcept {
-    if(size != other.size) return false;
-    for(iterator f_it = begin(),
-                 s_it = other.begin(),
-                 f_end = end();
-        f_it != f_end; (++f_it, ++s_it))
-      if(*f_it != *s_it) return false;
-    return true;
+  void append(const void* data, size_t size) noexcept {
+    BufferView range = reserveAppend(size);
+    memcpy(range.getData(), data, size);
+    commit(range);
   }
 
-  bool operator!=(const BufferController& other) noexcept {return !(*this == other);}
+  size_t getCommittedSize() const noexcept {return committed.value.load(std::memory_order_acquire);}
 
-  bool operator!=(BufferController&& other) noexcept {return !(*this == std::move(other));}
+  // Calls callback(BufferView) with the committed bytes, growth waits until it returns.
+  // The calling thread must not hold an uncommitted range
+  template<typename F>
+  void read(F&& callback) noexcept {
+    enter();
+    callback(BufferView(buffer.getData(), getCommittedSize()));
+    leave();
+  }
 
+  // Moves the committed bytes out, no thread may append or read concurrently
+  Buffer takeBuffer() noexcept {
+    buffer.resize(getCommittedSize());
+    Buffer result(std::move(buffer));
+    reserved.value.store(0, std::memory_order_relaxed);
+    committed.value.store(0, std::memory_order_relaxed);
+    buffer.resize(buffer.getCapacity());
+    capacity = buffer.getSize();
+    return result;
+  }
 };
 
+typedef BasicAppendController<> AppendController;
 
-template<>
-BufferController* BufferController::pushBack<BufferController>(const BufferController& value) noexcept {
-  pushBack(value, static_cast<Error*>(nullptr));
-  return this;
-}
-
-template<>
-BufferController* BufferController::pushBack(BufferController&& value) noexcept {
-  pushBack(std::move(value), static_cast<Error*>(nullptr));
-  return this;
-}
-
-template<>
-BufferController* BufferController::insert(size_t index, size_t shift, const BufferController& value, Error* err) noexcept {
-  insert(index + shift, value.data, value.size, err);
-  return this;
-}
+enum class Endian {
+  little,
+  big,
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  native = big
+#else
+  native = little
+#endif
+};
 
-template<>
-BufferController* BufferController::insert(size_t index, size_t shift, BufferController&& value, Error* err) noexcept {
-  insert(index + shift, value.data, value.size, err);
-  return this;
-}
+inline uint8_t byteSwap(uint8_t value) noexcept {return value;}
 
-template<>
-BufferController* BufferController::pushFront(const BufferController& value) noexcept {
-  pushFront(value, static_cast<Error*>(nullptr));
-  return this;
-}
+#ifdef _MSC_VER
+inline uint16_t byteSwap(uint16_t value) noexcept {return _byteswap_ushort(value);}
+inline uint32_t byteSwap(uint32_t value) noexcept {return _byteswap_ulong(value);}
+inline uint64_t byteSwap(uint64_t value) noexcept {return _byteswap_uint64(value);}
+#else
+inline uint16_t byteSwap(uint16_t value) noexcept {return __builtin_bswap16(value);}
+inline uint32_t byteSwap(uint32_t value) noexcept {return __builtin_bswap32(value);}
+inline uint64_t byteSwap(uint64_t value) noexcept {return __builtin_bswap64(value);}
+#endif
 
-template<>
-BufferController* BufferController::pushFront(BufferController&& value) noexcept {
-  pushFront(std::move(value), static_cast<Error*>(nullptr));
-  return this;
-}
+template<size_t Size> struct UnsignedOfSize;
+template<> struct UnsignedOfSize<1> {typedef uint8_t Type;};
+template<> struct UnsignedOfSize<2> {typedef uint16_t Type;};
+template<> struct UnsignedOfSize<4> {typedef uint32_t Type;};
+template<> struct UnsignedOfSize<8> {typedef uint64_t Type;};
 
-template<>
-const BufferController* BufferController::pushBack(const BufferController&& value) noexcept {
-  pushBack(std::move(value), static_cast<Error*>(nullptr));
-  return this;
+// Unaligned load and store of a value in the given byte order. memcpy compiles
+// to a plain move and the swap to bswap, or to movbe where it is enabled
+template<typename T, Endian E = Endian::native>
+T loadEndian(const void* data) noexcept {
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+  typedef typename UnsignedOfSize<sizeof (T)>::Type Unsigned;
+  Unsigned bits;
+  memcpy(&bits, data, sizeof (T));
+  if constexpr (E != Endian::native) bits = byteSwap(bits);
+  T value;
+  memcpy(&value, &bits, sizeof (T));
+  return value;
 }
 
-template<>
-const BufferController* BufferController::insert(size_t index, size_t shift, const BufferController&& value, Error* err) noexcept {
-  insert(index + shift, value.data, value.size, err);
-  return this;
+template<Endian E = Endian::native, typename T>
+void storeEndian(void* data, T value) noexcept {
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+  typedef typename UnsignedOfSize<sizeof (T)>::Type Unsigned;
+  Unsigned bits;
+  memcpy(&bits, &value, sizeof (T));
+  if constexpr (E != Endian::native) bits = byteSwap(bits);
+  memcpy(data, &bits, sizeof (T));
 }
 
-template<>
-const BufferController* BufferController::pushFront(const BufferController&& value) noexcept {
-  pushFront(std::move(value), static_cast<Error*>(nullptr));
-  return this;
-}
+// Cursor reading values in a fixed byte order, every single read checks bounds.
+// readBE and readLE check bounds once for the whole batch of fields
+class BufferReader {
+  BufferView view;
+  size_t position = 0;
 
+  template<Endian E, typename... T>
+  bool readAll(Error* err, T&... values) noexcept {
+    if(!require((sizeof (T) + ... + 0), err)) return false;
+    const uint8_t* at = static_cast<const uint8_t*>(view.getData()) + position;
+    ((values = loadEndian<T, E>(at), at += sizeof (T)), ...);
+    position += (sizeof (T) + ... + 0);
+    return true;
+  }
 
-template<typename T>
-class TypedInterface {
-  BufferController& buffer;
 public:
+  BufferReader() noexcept = default;
+  BufferReader(const BufferView& view) noexcept : view(view) {}
+  template<typename Buffer>
+  BufferReader(const Buffer& buffer) noexcept : view(buffer.view()) {}
 
-  typedef T Type;
-  typedef T* iterator;
-  typedef const T* const_iterator;
-  typedef std::reverse_iterator<iterator> reverse_iterator;
-  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
-
-  TypedInterface(BufferController& buffer) noexcept : buffer(buffer) {}
-
-  void resize(size_t count) {return buffer.resize<T>(count);}
-  void reserve(size_t count) {return buffer.reserve<T>(count);}
-
-  size_t getCount() const noexcept {return buffer.getCount<T>();}
+  size_t getPosition() const noexcept {return position;}
+  size_t getRemaining() const noexcept {return view.getSize() - position;}
+  bool isEnd() const noexcept {return position == view.getSize();}
 
-  template<typename... Args>
-  T* emplaceBack(Args&&... args) noexcept {
-    return buffer.emplaceBack(args...);
+  bool require(size_t size, Error* err = nullptr) const noexcept {
+    if(size > view.getSize() - position) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    return true;
   }
 
-  template<typename... Args>
-  T* emplaceAt(size_t index, size_t shift, Args&&... args, Error* err = nullptr) noexcept {
-    return buffer.emplaceAt(index, shift, args..., err);
+  bool seek(size_t position, Error* err = nullptr) noexcept {
+    if(position > view.getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    this->position = position;
+    return true;
   }
 
-  template<typename... Args>
-  T* emplaceFront(Args&&... args) noexcept {
-    return buffer.emplaceFront(args...);
+  bool skip(size_t size, Error* err = nullptr) noexcept {
+    if(!require(size, err)) return false;
+    position += size;
+    return true;
   }
 
-  void destruct(size_t at, size_t shift, size_t count = 1, Error* err = nullptr) noexcept {
-    return buffer.destruct<T>(at, shift, count, err);
+  // Returns zero if the value is out of the view
+  template<typename T, Endian E = Endian::native>
+  T read(Error* err = nullptr) noexcept {
+    if(!require(sizeof (T), err)) return T();
+    T value = loadEndian<T, E>(static_cast<const uint8_t*>(view.getData()) + position);
+    position += sizeof (T);
+    return value;
   }
 
-  T* pushBack(const T& value) noexcept {return buffer.pushBack<T>(&value, sizeof (T));}
+  uint8_t readU8(Error* err = nullptr) noexcept {return read<uint8_t>(err);}
+  uint16_t readU16BE(Error* err = nullptr) noexcept {return read<uint16_t, Endian::big>(err);}
+  uint16_t readU16LE(Error* err = nullptr) noexcept {return read<uint16_t, Endian::little>(err);}
+  uint32_t readU32BE(Error* err = nullptr) noexcept {return read<uint32_t, Endian::big>(err);}
+  uint32_t readU32LE(Error* err = nullptr) noexcept {return read<uint32_t, Endian::little>(err);}
+  uint64_t readU64BE(Error* err = nullptr) noexcept {return read<uint64_t, Endian::big>(err);}
+  uint64_t readU64LE(Error* err = nullptr) noexcept {return read<uint64_t, Endian::little>(err);}
 
-  T* pushBack(T&& value) noexcept {return buffer.emplaceBack<T>(std::move(value));}
+  // Reads all fields or none of them
+  template<typename... T>
+  bool readBE(T&... values) noexcept {return readAll<Endian::big>(nullptr, values...);}
+  template<typename... T>
+  bool readLE(T&... values) noexcept {return readAll<Endian::little>(nullptr, values...);}
 
-  T* insert(size_t index, size_t shift, const T& value, Error* err = nullptr) noexcept {
-    return buffer.insert(index, shift, value, err);
+  BufferView readBytes(size_t size, Error* err = nullptr) noexcept {
+    if(!require(size, err)) return BufferView();
+    BufferView bytes = view.slice(position, size);
+    position += size;
+    return bytes;
+  }
+};
+
+// Cursor writing values in a fixed byte order, starts at the end of the buffer
+// and grows it when a write goes past the end. writeBE and writeLE grow the
+// buffer once for the whole batch of fields
+template<typename Buffer = BufferController>
+class BasicBufferWriter {
+  Buffer& buffer;
+  size_t position;
+
+  uint8_t* require(size_t size) noexcept {
+    if(position + size > buffer.getSize()) buffer.addSizeToBack(position + size - buffer.getSize());
+    return static_cast<uint8_t*>(buffer.getData()) + position;
   }
 
-  T* insert(size_t index, size_t shift, T&& value, Error* err = nullptr) noexcept {
-    return buffer.emplaceAt<T>(index, shift, std::move(value), err);
+  template<Endian E, typename... T>
+  void writeAll(T... values) noexcept {
+    uint8_t* at = require((sizeof (T) + ... + 0));
+    ((storeEndian<E>(at, values), at += sizeof (T)), ...);
+    position += (sizeof (T) + ... + 0);
   }
 
-  T* pushFront(const T& value) noexcept {return buffer.pushBack(value);}
+public:
+  BasicBufferWriter(Buffer& buffer) noexcept : buffer(buffer), position(buffer.getSize()) {}
+
+  size_t getPosition() const noexcept {return position;}
 
-  T* pushFront(T&& value) noexcept {return buffer.emplaceFront<T>(std::move(value));}
+  bool seek(size_t position, Error* err = nullptr) noexcept {
+    if(position > buffer.getSize()) {
+      if(err) *err = ErrorType::out_of_range;
+      return false;
+    }
+    this->position = position;
+    return true;
+  }
 
-  iterator begin() const noexcept {return buffer.begin<T>();}
-  iterator end() const noexcept {return buffer.end<T>();}
+  template<typename T, Endian E = Endian::native>
+  void write(T value) noexcept {writeAll<E>(value);}
 
-  const_iterator cbegin() const noexcept {return buffer.cbegin<T>();}
-  const_iterator cend() const noexcept {return buffer.cend<T>();}
+  void writeU8(uint8_t value) noexcept {write(value);}
+  void writeU16BE(uint16_t value) noexcept {write<uint16_t, Endian::big>(value);}
+  void writeU16LE(uint16_t value) noexcept {write<uint16_t, Endian::little>(value);}
+  void writeU32BE(uint32_t value) noexcept {write<uint32_t, Endian::big>(value);}
+  void writeU32LE(uint32_t value) noexcept {write<uint32_t, Endian::little>(value);}
+  void writeU64BE(uint64_t value) noexcept {write<uint64_t, Endian::big>(value);}
+  void writeU64LE(uint64_t value) noexcept {write<uint64_t, Endian::little>(value);}
 
-  reverse_iterator rbegin() const noexcept {return buffer.rbegin<T>();}
-  reverse_iterator rend() const noexcept {return buffer.rend<T>();}
+  template<typename... T>
+  void writeBE(T... values) noexcept {writeAll<Endian::big>(values...);}
+  template<typename... T>
+  void writeLE(T... values) noexcept {writeAll<Endian::little>(values...);}
 
-  const_reverse_iterator crbegin() const noexcept {return buffer.crbegin<T>();}
-  const_reverse_iterator crend() const noexcept {return buffer.crend<T>();}
+  void writeBytes(const void* data, size_t size) noexcept {
+    memcpy(require(size), data, size);
+    position += size;
+  }
 };
 
+typedef BasicBufferWriter<> BufferWriter;
+
 }
 
 #endif // MEMORYCTRL_H
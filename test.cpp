@@ -1,8 +1,625 @@
 #include <iostream>
+#include <cassert>
+#include <thread>
+#include <string>
 #include "memoryctrl.hpp"
 
 using namespace std;
 
+#ifdef MEMORYCTRL_POSIX
+// Callbacks queue follow-up reads while the ring is full
+void testAsyncRequeue(bool use_uring) {
+  using namespace memctrl;
+  char path[] = "/tmp/memoryctrl-test-XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  unlink(path);
+  char data[4096];
+  for(size_t index = 0; index < sizeof data; ++index) data[index] = char(index);
+  assert(write(fd, data, sizeof data) == ssize_t(sizeof data));
+
+  AsyncIO io(2, 1, use_uring);
+  char chunks[8][64];
+  size_t completed = 0;
+  for(int index = 0; index < 4; ++index)
+    io.read(fd, BufferView(chunks[index], 64), index * 64, [&, index](ssize_t result) {
+      assert(result == 64 && chunks[index][0] == char(index * 64));
+      ++completed;
+      io.read(fd, BufferView(chunks[index + 4], 64), (index + 4) * 64, [&, index](ssize_t result) {
+        assert(result == 64 && chunks[index + 4][0] == char((index + 4) * 64));
+        ++completed;
+      });
+    });
+  while(io.getInFlightCount()) io.wait(io.getInFlightCount());
+  assert(completed == 8);
+  close(fd);
+}
+
+// Mapped files are read-only views of the file, typed access reads the bytes in place
+void testMapFile() {
+  using namespace memctrl;
+  char path[] = "/tmp/memoryctrl-test-XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  uint32_t values[1024];
+  for(uint32_t index = 0; index < 1024; ++index) values[index] = index * 3;
+  assert(write(fd, values, sizeof values) == ssize_t(sizeof values));
+  close(fd);
+
+  Error err = ErrorType::no_error;
+  MappedFileController mapped = mapFile(path, &err);
+  assert(err == ErrorType::no_error && mapped.getSize() == sizeof values && mapped.getCount<uint32_t>() == 1024);
+  mapped.advise(Advice::populate, &err);
+  assert(err == ErrorType::no_error);
+  assert(mapped.get<uint32_t>(7, 0) == 21 && mapped.end<uint32_t>()[-1] == 1023 * 3);
+  uint64_t sum = 0;
+  for(uint32_t value : mapped.as<uint32_t>()) sum += value;
+  for(uint32_t value : TypedInterface<const uint32_t, MappedFileController>(mapped)) sum += value;
+  assert(sum == 3 * 1023 * 1024);
+  assert(!memcmp(mapped.begin(), values, sizeof values));
+
+  MappedFileController moved;
+  moved = std::move(mapped);
+  assert(mapped.isEmpty() && moved.view() == BufferView(values, sizeof values));
+  moved = mapFile("/nonexistent/memoryctrl", &err);
+  assert(err == ErrorType::system_error && moved.isEmpty());
+  unlink(path);
+}
+
+// Populating prefaults writable buffers, a read-only range is faulted in for reading and reported
+void testPopulate() {
+  using namespace memctrl;
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  Error err = ErrorType::no_error;
+  BufferController buffer;
+  buffer.reserve(size_t(4) << 20, Advice::populate, &err);
+  assert(err == ErrorType::no_error);
+  uint8_t* first = reinterpret_cast<uint8_t*>((uintptr_t(buffer.begin()) + page_size - 1) & ~(page_size - 1));
+  size_t length = (buffer.begin() + buffer.getCapacity() - first) & ~(page_size - 1);
+  std::vector<unsigned char> pages(length / page_size);
+  assert(!mincore(first, length, pages.data()));
+  for(unsigned char page : pages) assert(page & 1);
+
+  size_t size = 1 << 16;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  assert(data != MAP_FAILED);
+  BasicBufferController<MappedAllocator<4096, 4096>> read_only = BasicBufferController<MappedAllocator<4096, 4096>>::move(data, size);
+  read_only.advise(Advice::populate, &err);
+  assert(err == ErrorType::system_error);
+}
+
+// Views taken from the back keep their bytes even when the allocator returns pages on shrink
+void testDequeTakeBackView() {
+  using namespace memctrl;
+  BasicDequeController<BasicBufferController<MappedAllocator<4096, 4096>>> deque;
+  for(uint32_t index = 0; index < (1 << 18); ++index) deque.pushBack(&index, sizeof index);
+  deque.subSizeFront(4096);
+  BufferView back = deque.takeBackView(1 << 19);
+  uint32_t first = (1 << 18) - (1 << 17);
+  for(uint32_t index = 0; index < (1 << 17); ++index) assert(back.get<uint32_t>(index, 0) == first + index);
+  assert(deque.getSize() == (1 << 20) - 4096 - (1 << 19));
+}
+
+// The payload survives reopening, files not written by FileController are rejected untouched
+void testFileController() {
+  using namespace memctrl;
+  char path[] = "/tmp/memoryctrl-test-XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  close(fd);
+
+  Error err = ErrorType::no_error;
+  {
+    FileController file;
+    assert(!file.isOpen());
+    file = FileController(path, &err);
+    assert(err == ErrorType::no_error && file.isOpen() && file.isEmpty());
+    file.setSyncOnCommit(true);
+    FileController moved(std::move(file));
+    assert(moved.isOpen() && moved.isSyncOnCommit() && !file.isOpen());
+    file = std::move(moved);
+    assert(file.isOpen() && file.isSyncOnCommit() && !moved.isOpen());
+    for(uint32_t index = 0; index < 10000; ++index) file.pushBack(index, &err);
+    uint8_t* reserved = file.reserveBack(4, &err);
+    memcpy(reserved, "tail", 4);
+    assert(file.getSize() == 40000);
+    file.commitBack(4, &err);
+    assert(err == ErrorType::no_error && file.getSize() == 40004);
+  }
+  {
+    FileController file(path, &err);
+    assert(err == ErrorType::no_error && file.getSize() == 40004);
+    for(uint32_t index = 0; index < 10000; ++index) assert(file.get<uint32_t>(index, 0) == index);
+    assert(file.view().slice(40000, 4) == BufferView("tail", 4));
+  }
+
+  // Zeroed header, the file only looks empty
+  char foreign[4096 + 9] = {};
+  memcpy(foreign + 4096, "IMPORTANT", 9);
+  fd = open(path, O_WRONLY | O_TRUNC);
+  assert(write(fd, foreign, sizeof foreign) == ssize_t(sizeof foreign));
+  close(fd);
+  {
+    FileController file(path, &err);
+    assert(err == ErrorType::out_of_range && !file.isOpen());
+  }
+  char contents[sizeof foreign];
+  fd = open(path, O_RDONLY);
+  assert(read(fd, contents, sizeof contents) == ssize_t(sizeof contents) && !memcmp(contents, foreign, sizeof foreign));
+  close(fd);
+  unlink(path);
+}
+
+// Many small shrinks release the pages past the margin, not only single large ones
+void testMappedRelease() {
+  using namespace memctrl;
+  const size_t margin = size_t(1) << 20, page_size = sysconf(_SC_PAGESIZE);
+  BasicBufferController<MappedAllocator<margin, margin>> buffer;
+  buffer.resize(size_t(32) << 20);
+  memset(buffer.begin(), 1, buffer.getSize());
+  auto getResident = [&] {
+    std::vector<unsigned char> pages((buffer.getCapacity() + page_size - 1) / page_size);
+    assert(!mincore(buffer.begin(), buffer.getCapacity(), pages.data()));
+    size_t resident = 0;
+    for(unsigned char page : pages) resident += (page & 1) * page_size;
+    return resident;
+  };
+  for(size_t index = 0; index < 96; ++index) buffer.subSizeBack(margin / 4);
+  assert(buffer.getSize() == size_t(8) << 20);
+  assert(getResident() <= buffer.getSize() + 2 * margin);
+  for(size_t index = 0; index < 4; ++index) buffer.subSizeBack(3 * margin / 2);
+  assert(getResident() <= buffer.getSize() + 2 * margin);
+  assert(buffer.get<uint32_t>(0, 0) == 0x01010101 && buffer.last() == 1);
+}
+#endif
+
+// Shifts of the buffer tail go through the thread pool in non-overlapping rounds
+void testParallelShift() {
+  using namespace memctrl;
+  ParallelCopy::setThreadCount(2);
+  ParallelCopy::setThreshold(size_t(64) << 10);
+  ParallelCopy::setStreamingThreshold(size_t(1) << 20);
+
+  BufferController buffer;
+  for(uint32_t index = 0; index < (1 << 20); ++index) buffer.pushBack(index);
+  BufferController original(buffer);
+  BufferController block;
+  for(uint32_t index = 0; index < (1 << 16); ++index) block.pushBack(~index);
+
+  Error err = ErrorType::no_error;
+  size_t at = (size_t(1) << 20) + 12;
+  buffer.insert(at, block, &err);
+  assert(err == ErrorType::no_error && buffer.getSize() == original.getSize() + block.getSize());
+  assert(!memcmp(buffer.begin(), original.begin(), at));
+  assert(!memcmp(buffer.begin() + at, block.begin(), block.getSize()));
+  assert(!memcmp(buffer.begin() + at + block.getSize(), original.begin() + at, original.getSize() - at));
+
+  BufferController taken = buffer.takeFrom(at, block.getSize(), &err);
+  assert(err == ErrorType::no_error && taken.getSize() == block.getSize());
+  assert(!memcmp(taken.begin(), block.begin(), block.getSize()));
+  assert(buffer.getSize() == original.getSize() && !memcmp(buffer.begin(), original.begin(), original.getSize()));
+
+  buffer.pushFront(block.begin(), block.getSize(), &err);
+  assert(!memcmp(buffer.begin() + block.getSize(), original.begin(), original.getSize()));
+  taken = buffer.takeFront(block.getSize(), &err);
+  assert(!memcmp(buffer.begin(), original.begin(), original.getSize()));
+
+  buffer.insert(at, "abcd", 4, &err);
+  assert(!memcmp(buffer.begin() + at + 4, original.begin() + at, original.getSize() - at));
+  assert(buffer.insert(buffer.getSize() + 1, "abcd", 4, &err) == buffer.end() && err == ErrorType::out_of_range);
+
+  // Streaming without worker threads
+  ParallelCopy::setThreadCount(0);
+  BufferController streamed(original);
+  assert(streamed.getSize() == original.getSize() && !memcmp(streamed.begin(), original.begin(), original.getSize()));
+
+  ParallelCopy::setThreshold(size_t(4) << 20);
+  ParallelCopy::setStreamingThreshold(ParallelCopy::getLastLevelCacheSize());
+}
+
+
+// One producer and one consumer, values and records keep their order across wraps
+void testRingThreads() {
+  using namespace memctrl;
+  const uint32_t count = 30000;
+  {
+    RingController ring(16);
+    uint8_t bytes[12] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    assert(ring.pushBytes(bytes, 12) && !ring.pushBytes(bytes, 12));
+    assert(ring.push(bytes, 12) == 4);
+    uint8_t output[16];
+    assert(ring.popBytes(output, 20) == 16 && !memcmp(output, bytes, 12) && !memcmp(output + 12, bytes, 4));
+  }
+  {
+    RingController ring(1024);
+    std::thread producer([&] {
+      for(uint64_t index = 0; index < count;) {
+        uint64_t batch[7];
+        size_t size = 0;
+        for(; size < 7 && index + size < count; ++size) batch[size] = index + size;
+        index += ring.push(batch, size);
+      }
+    });
+    for(uint64_t expected = 0; expected < count;) {
+      uint64_t batch[13];
+      size_t size = ring.pop(batch, 13);
+      for(size_t index = 0; index < size; ++index) assert(batch[index] == expected++);
+    }
+    producer.join();
+    assert(ring.isEmpty());
+  }
+  {
+    RingController ring(4096);
+    std::thread producer([&] {
+      for(uint32_t index = 0; index < count;) {
+        std::vector<uint8_t> storage[4];
+        BufferView records[4];
+        size_t size = 0;
+        for(; size < 4 && index + size < count; ++size) {
+          uint32_t id = index + size;
+          storage[size].assign(sizeof id + id % 250, uint8_t(id));
+          memcpy(storage[size].data(), &id, sizeof id);
+          records[size] = BufferView(storage[size].data(), storage[size].size());
+        }
+        index += ring.pushRecords(records, size);
+      }
+    });
+    uint32_t expected = 0;
+    while(expected < count)
+      ring.popRecords([&](const BufferView& record) {
+        uint32_t id;
+        memcpy(&id, record.getData(), sizeof id);
+        assert(id == expected++ && record.getSize() == sizeof id + id % 250);
+        assert(record.slice(sizeof id, id % 250).count(uint8_t(id)) == id % 250);
+      });
+    producer.join();
+    assert(ring.isEmpty());
+  }
+}
+
+
+// Several producers and consumers, nothing is lost or duplicated and each producer's values stay in order
+void testQueueThreads() {
+  using namespace memctrl;
+  {
+    BoundedQueue<std::string> queue(3);
+    assert(queue.getCapacity() == 4);
+    for(char letter = 'a'; letter < 'e'; ++letter) assert(queue.tryPush(std::string(40, letter)));
+    assert(!queue.tryPush("full"));
+    std::string value;
+    assert(queue.tryPop(value) && value == std::string(40, 'a'));
+    assert(queue.tryEmplace(3, 'z'));
+  }
+
+  struct Item {uint32_t producer; uint32_t index;};
+  const uint32_t producer_count = 4, consumer_count = 4, count = 20000;
+  BoundedQueue<Item> queue(256);
+  std::atomic<uint64_t> popped(0), sum(0);
+  std::vector<std::thread> threads;
+  for(uint32_t producer = 0; producer < producer_count; ++producer)
+    threads.emplace_back([&, producer] {
+      for(uint32_t index = 0; index < count;) {
+        if(producer % 2) {
+          queue.push(Item{producer, index++});
+          continue;
+        }
+        Item batch[5];
+        size_t size = 0;
+        for(; size < 5 && index + size < count; ++size) batch[size] = Item{producer, uint32_t(index + size)};
+        queue.pushBulk(batch, size);
+        index += size;
+      }
+    });
+  for(uint32_t consumer = 0; consumer < consumer_count; ++consumer)
+    threads.emplace_back([&, consumer] {
+      std::vector<int64_t> last(producer_count, -1);
+      while(popped.load() < uint64_t(producer_count) * count) {
+        Item batch[7];
+        size_t size = consumer % 2 ? queue.tryPopBulk(batch, 7) : queue.tryPop(batch[0]);
+        for(size_t index = 0; index < size; ++index) {
+          assert(int64_t(batch[index].index) > last[batch[index].producer]);
+          last[batch[index].producer] = batch[index].index;
+          sum += batch[index].index;
+        }
+        popped += size;
+      }
+    });
+  for(auto& thread : threads) thread.join();
+  assert(popped == uint64_t(producer_count) * count && queue.getSize() == 0);
+  assert(sum == uint64_t(producer_count) * (uint64_t(count) * (count - 1) / 2));
+}
+
+
+// Writers reserve and commit records while a reader scans the committed prefix
+void testAppendThreads() {
+  using namespace memctrl;
+  const uint32_t thread_count = 6, count = 3000;
+  AppendController log(16);
+  std::atomic<bool> done(false);
+  std::thread scanner([&] {
+    while(!done)
+      log.read([](const BufferView& view) {
+        BufferReader reader(view);
+        uint32_t thread, index, size;
+        while(reader.readLE(thread, index, size)) assert(reader.readBytes(size).count(uint8_t(thread)) == size);
+        assert(reader.isEnd());
+      });
+  });
+  std::vector<std::thread> writers;
+  for(uint32_t thread = 0; thread < thread_count; ++thread)
+    writers.emplace_back([&, thread] {
+      for(uint32_t index = 0; index < count; ++index) {
+        uint32_t header[3] = {thread, index, (index * 7 + thread) % 100};
+        BufferView range = log.reserveAppend(sizeof header + header[2]);
+        memcpy(range.getData(), header, sizeof header);
+        memset(static_cast<uint8_t*>(range.getData()) + sizeof header, thread, header[2]);
+        log.commit(range);
+      }
+    });
+  for(auto& writer : writers) writer.join();
+  done = true;
+  scanner.join();
+
+  BufferController result = log.takeBuffer();
+  assert(log.getCommittedSize() == 0);
+  std::vector<uint32_t> next(thread_count, 0);
+  BufferReader reader(result);
+  uint32_t thread, index, size, total = 0;
+  for(; reader.readLE(thread, index, size); ++total) {
+    assert(index == next[thread]++);
+    reader.skip(size);
+  }
+  assert(total == thread_count * count && reader.isEnd());
+}
+
+
+// Batches are one reservation holding several records, the buffer grows between them
+void testAppendBatch() {
+  using namespace memctrl;
+  AppendController log(16);
+  for(uint32_t batch = 0; batch < 100; ++batch) {
+    BufferView range = log.reserveAppend(3 * sizeof batch);
+    for(uint32_t index = 0; index < 3; ++index) {
+      uint32_t value = batch * 3 + index;
+      memcpy(static_cast<uint8_t*>(range.getData()) + index * sizeof value, &value, sizeof value);
+    }
+    log.commit(range);
+    log.read([&](const BufferView& view) {assert(view.getSize() == (batch + 1) * 3 * sizeof batch);});
+  }
+  BufferController result = log.takeBuffer();
+  for(uint32_t index = 0; index < 300; ++index) assert(result.get<uint32_t>(index, 0) == index);
+}
+
+
+// Front consumption moves the head, resizing to zero drops the consumed bytes too
+void testDeque() {
+  using namespace memctrl;
+  DequeController deque;
+  for(uint32_t index = 0; index < 1000; ++index) deque.pushBack(index);
+  for(uint32_t index = 0; index < 500; ++index) {
+    uint32_t value;
+    assert(deque.takeFront(value) && value == index);
+  }
+  assert(deque.getSize() == 500 * sizeof (uint32_t) && deque.getHeadOffset() == 500 * sizeof (uint32_t));
+  for(uint32_t index = 500; index-- > 0;) deque.pushFront(index);
+  for(uint32_t index = 0; index < 1000; ++index) assert(deque.get<uint32_t>(index, 0) == index);
+
+  Error err = ErrorType::no_error;
+  BufferView front = deque.takeFrontView(8, &err);
+  assert(err == ErrorType::no_error && front.get<uint32_t>(1, 0) == 1);
+  deque.compact();
+  assert(deque.getHeadOffset() == 0 && deque.get<uint32_t>(0, 0) == 2);
+
+  deque.subSizeFront(8);
+  deque.resize(0);
+  assert(deque.getSize() == 0 && deque.isEmpty());
+  deque.pushBack(uint32_t(7));
+  assert(deque.getSize() == 4 && deque.get<uint32_t>(0, 0) == 7);
+}
+
+
+// Random inserts and removes match the same edits on a string
+void testGap() {
+  using namespace memctrl;
+  GapController gap;
+  std::string model;
+  uint32_t seed = 1;
+  auto next = [&seed](size_t bound) {
+    seed = seed * 1103515245 + 12345;
+    return size_t(seed >> 8) % bound;
+  };
+  for(size_t step = 0; step < 5000; ++step) {
+    size_t at = next(model.size() + 1);
+    if(next(3)) {
+      std::string text(next(16), char('a' + step % 26));
+      gap.insert(at, text.data(), text.size());
+      model.insert(at, text);
+    } else {
+      size_t count = next(model.size() - at + 1);
+      gap.remove(at, count);
+      model.erase(at, count);
+    }
+    assert(gap.getSize() == model.size());
+    if(step % 100 == 0)
+      for(size_t index = 0; index < model.size(); ++index) assert(gap[index] == uint8_t(model[index]));
+  }
+  Error err = ErrorType::no_error;
+  assert(!gap.insert(model.size() + 1, "x", 1, &err) && err == ErrorType::out_of_range);
+  err = ErrorType::no_error;
+  gap.remove(model.size(), 1, &err);
+  assert(err == ErrorType::out_of_range);
+  gap.compact();
+  assert(gap.isContiguous() && size_t(gap.end() - gap.begin()) == model.size());
+  assert(!memcmp(gap.begin(), model.data(), model.size()));
+}
+
+
+// Chunks are linked without copying, reads and front consumption cross chunk boundaries
+void testSegmented() {
+  using namespace memctrl;
+  SegmentedController segmented;
+  std::string model;
+  for(size_t index = 0; index < 20; ++index) {
+    std::string text(index % 7 + 1, char('a' + index));
+    BufferController chunk(text.data(), text.size());
+    const void* chunk_data = chunk.getData();
+    segmented.append(std::move(chunk));
+    assert(segmented.getChunks().back().getData() == chunk_data);
+    model += text;
+  }
+  segmented.append(BufferController());
+  assert(segmented.getSize() == model.size() && segmented.getChunkCount() == 20);
+  assert(std::string(segmented.begin(), segmented.end()) == model);
+
+  segmented.subSizeFront(3);
+  model.erase(0, 3);
+  segmented.subSizeFront(5);
+  model.erase(0, 5);
+  assert(std::string(segmented.begin(), segmented.end()) == model);
+  for(size_t index = 0; index < model.size(); ++index) assert(segmented[index] == uint8_t(model[index]));
+
+  SegmentedController other{BufferController("0123", 4), BufferController("4567", 4)};
+  other.subSizeFront(2);
+  segmented.append(std::move(other));
+  model += "234567";
+  assert(other.isEmpty() && segmented.getSize() == model.size());
+  segmented.pushFront("<<", 2);
+  model.insert(0, "<<");
+  assert(std::string(segmented.begin(), segmented.end()) == model);
+
+  BufferController flat = segmented.flatten();
+  assert(flat.view() == BufferView(model.data(), model.size()));
+  assert(segmented.compact().view() == BufferView(model.data(), model.size()) && segmented.getChunkCount() == 1);
+  segmented.subSizeFront(model.size());
+  assert(segmented.isEmpty() && segmented.begin() == segmented.end());
+}
+
+
+// Slices share the bytes, writes detach a private copy and leave the other owners unchanged
+void testShared() {
+  using namespace memctrl;
+  SharedController shared("shared bytes", 12);
+  SharedController slice = shared.slice(7, 5);
+  assert(slice.view() == BufferView("bytes", 5) && slice.begin() == shared.begin() + 7);
+  assert(shared.getUseCount() == 2 && !shared.isUnique());
+
+  BufferView writable = slice.mutableView();
+  writable[0] = 'B';
+  assert(slice.view() == BufferView("Bytes", 5) && shared.view() == BufferView("shared bytes", 12));
+  assert(slice.isUnique() && shared.isUnique());
+
+  SharedController copy = shared;
+  copy.subSizeFront(7);
+  copy.pushBack("!", 1);
+  assert(copy.view() == BufferView("bytes!", 6) && shared.view() == BufferView("shared bytes", 12));
+  const uint8_t* data = copy.begin();
+  copy.pushBack("?", 1);
+  assert(copy.begin() == data && copy.view() == BufferView("bytes!?", 7));
+
+  std::vector<std::thread> threads;
+  for(size_t index = 0; index < 4; ++index)
+    threads.emplace_back([shared] {
+      for(size_t step = 0; step < 10000; ++step) {
+        SharedController local = shared.slice(step % 12, 0);
+        assert(local.getUseCount() >= 2);
+      }
+    });
+  for(auto& thread : threads) thread.join();
+  assert(shared.isUnique());
+}
+
+
+// Every kernel the CPU supports finds the first differing byte at any length, position and alignment
+void testCompare() {
+  using namespace memctrl;
+  typedef size_t (*Kernel)(const uint8_t*, const uint8_t*, size_t);
+  std::vector<Kernel> kernels{simd::firstMismatchScalar};
+#ifdef MEMORYCTRL_X86_SIMD
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("sse2")) kernels.push_back(simd::firstMismatchSSE2);
+  if(__builtin_cpu_supports("avx2")) kernels.push_back(simd::firstMismatchAVX2);
+  if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) kernels.push_back(simd::firstMismatchAVX512);
+#endif
+  uint8_t first[300], second[300];
+  for(size_t index = 0; index < sizeof first; ++index) first[index] = uint8_t(index * 7);
+  for(size_t offset = 0; offset < 3; ++offset)
+    for(size_t size = 0; size + offset <= 260; ++size)
+      for(size_t mismatch = 0; mismatch <= size; ++mismatch) {
+        memcpy(second, first, sizeof first);
+        if(mismatch < size) second[offset + mismatch] ^= 0x80;
+        for(Kernel kernel : kernels) assert(kernel(first + offset, second + offset, size) == mismatch);
+        assert(simd::firstMismatch(first + offset, second + offset, size) == mismatch);
+        int expected = memcmp(first + offset, second + offset, size);
+        int result = BufferView(first + offset, size).compare(BufferView(second + offset, size));
+        assert((result < 0) == (expected < 0) && (result > 0) == (expected > 0));
+      }
+  assert(BufferView("abc", 3) < BufferView("abd", 3) && BufferView("ab", 2) < BufferView("abc", 3));
+  assert(BufferView("\x80", 1).compare(BufferView("\x7F", 1)) > 0 && BufferView("abc", 3) == BufferView("abc", 3));
+  assert(BufferView("abcdef", 6).firstMismatch(BufferView("abcxef", 6)) == 3);
+}
+
+
+// Published check values, chained and streamed hashing match the one-shot results
+void testHash() {
+  using namespace memctrl;
+  assert(simd::crc32c("123456789", 9) == 0xE3069283);
+  assert(BufferView("123456789", 9).crc32c() == 0xE3069283 && simd::crc32c("", 0) == 0);
+  assert(xxhash64("", 0) == 0xEF46DB3751D8E999 && xxhash64("abc", 3) == 0x44BC2CF5AD770999);
+
+  uint8_t data[1000];
+  for(size_t index = 0; index < sizeof data; ++index) data[index] = uint8_t(index * 31 + 7);
+  assert(xxhash64(data, sizeof data) == 0x99594F4828043D35);
+  assert(BufferView(data, sizeof data).xxhash64(0x9E3779B97F4A7C15) == 0xDA717F741F399F3F);
+  assert(xxhash64("123456789", 9, 1) == 0x1A4CC2C9E8079790);
+
+  for(size_t size = 0; size <= 100; ++size)
+    for(size_t split = 0; split <= size; split += 7) {
+      assert(simd::crc32c(data + split, size - split, simd::crc32c(data, split)) == simd::crc32c(data, size));
+      assert(XXHash64(5).update(data, split).update(data + split, size - split).digest() == xxhash64(data, size, 5));
+#ifdef MEMORYCTRL_X86_SIMD
+      if(simd::hasCRC32()) assert(simd::crc32cSSE42(~0u, data + split, size) == simd::crc32cScalar(~0u, data + split, size));
+#endif
+    }
+}
+
+
+// Values land in the requested byte order and read back unchanged, short reads fail without moving
+void testEndian() {
+  using namespace memctrl;
+  BufferController buffer;
+  BufferWriter writer(buffer);
+  writer.writeU16BE(0x0102);
+  writer.writeU32LE(0x03040506);
+  writer.writeU64BE(0x0708090A0B0C0D0E);
+  writer.writeBE(uint8_t(0x0F), uint16_t(0x1011), int32_t(-2));
+  writer.writeLE(uint64_t(0x1213141516171819), 1.5);
+  writer.writeBytes("end", 3);
+  const uint8_t expected[] = {0x01, 0x02, 0x06, 0x05, 0x04, 0x03, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                              0x0F, 0x10, 0x11, 0xFF, 0xFF, 0xFF, 0xFE, 0x19, 0x18, 0x17, 0x16, 0x15, 0x14, 0x13, 0x12};
+  assert(buffer.getSize() == sizeof expected + 8 + 3 && !memcmp(buffer.begin(), expected, sizeof expected));
+
+  BufferReader reader(buffer);
+  assert(reader.readU16BE() == 0x0102 && reader.readU32LE() == 0x03040506 && reader.readU64BE() == 0x0708090A0B0C0D0E);
+  uint8_t byte;
+  uint16_t half;
+  int32_t negative;
+  assert(reader.readBE(byte, half, negative) && byte == 0x0F && half == 0x1011 && negative == -2);
+  uint64_t wide;
+  double real;
+  assert(reader.readLE(wide, real) && wide == 0x1213141516171819 && real == 1.5);
+  assert(reader.getRemaining() == 3);
+  Error err = ErrorType::no_error;
+  size_t position = reader.getPosition();
+  assert(!reader.readLE(wide) && reader.getPosition() == position);
+  assert(reader.readU32BE(&err) == 0 && err == ErrorType::out_of_range && reader.getPosition() == position);
+  assert(reader.readBytes(3) == BufferView("end", 3) && reader.isEnd());
+
+  writer.seek(2);
+  writer.writeU32BE(0x03040506);
+  assert(buffer.getSize() == sizeof expected + 8 + 3);
+  assert((loadEndian<uint32_t, Endian::big>(buffer.begin() + 2) == 0x03040506 && buffer[6] == 0x07));
+}
+
 
 int main() {
   using namespace memctrl;
@@ -26,5 +643,27 @@ int main() {
   }
   std::clog << std::endl;
 
+#ifdef MEMORYCTRL_POSIX
+  testAsyncRequeue(true);
+  testAsyncRequeue(false);
+  testMapFile();
+  testPopulate();
+  testDequeTakeBackView();
+  testFileController();
+  testMappedRelease();
+#endif
+  testParallelShift();
+  testDeque();
+  testGap();
+  testSegmented();
+  testShared();
+  testCompare();
+  testHash();
+  testEndian();
+  testRingThreads();
+  testQueueThreads();
+  testAppendThreads();
+  testAppendBatch();
+
   return 0;
 }